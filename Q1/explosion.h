@@ -0,0 +1,99 @@
+#ifndef EXPLOSION_H
+#define EXPLOSION_H
+
+#include <stdio.h>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <vector>
+
+#include "math_utils.h"
+#include "OFFReader.h"
+#include "log.h"
+
+// Displacement of every polygon for an explosion factor: outwards from the
+// vertex centroid through the triangle's centre, a tenth of the model extent
+// per unit of factor. Polygons that are not triangles stay in place.
+void computeExplosionOffsets(const OffModel* model, float explosionFactor, std::vector<Vector3f>& offsets) {
+    offsets.assign(model->numberOfPolygons, Vector3f(0.0f, 0.0f, 0.0f));
+
+    Vector3f modelCenter(0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < model->numberOfVertices; i++) {
+    modelCenter.x += model->vertices[i].x;
+    modelCenter.y += model->vertices[i].y;
+    modelCenter.z += model->vertices[i].z;
+    }
+    modelCenter = modelCenter * (1.0f / model->numberOfVertices);
+    float explosionDistance = explosionFactor * (model->extent / 10.0f);
+
+    for (int i = 0; i < model->numberOfPolygons; i++) {
+    if (model->polygons[i].noSides != 3) {
+    continue;
+    }
+
+    Vector3f triangleCenter(0.0f, 0.0f, 0.0f);
+    for (int j = 0; j < 3; j++) {
+    int vertIdx = model->polygons[i].v[j];
+    triangleCenter.x += model->vertices[vertIdx].x;
+    triangleCenter.y += model->vertices[vertIdx].y;
+    triangleCenter.z += model->vertices[vertIdx].z;
+    }
+    triangleCenter = triangleCenter * (1.0f / 3.0f);
+
+    Vector3f explosionDir = (triangleCenter - modelCenter).Normalize();
+    offsets[i] = explosionDir * explosionDistance;
+    }
+}
+
+void updateMeshExplosion(OffModel* model, float explosionFactor, 
+    const std::vector<Vector3f>& originalVertices,
+    Vector3f* faceNormals, Vector3f* faceCenters, 
+    GLuint VBO, int& numVertices) {
+
+    if (explosionFactor == 0.0f) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, model->numberOfVertices * sizeof(Vertex), 
+    model->vertices, GL_STATIC_DRAW);
+    numVertices = 0;
+    return;
+    }
+
+    std::vector<Vector3f> offsets;
+    computeExplosionOffsets(model, explosionFactor, offsets);
+
+    std::vector<Vertex> explodedVertices;
+    explodedVertices.reserve(model->numberOfPolygons * 3);
+
+    for (int i = 0; i < model->numberOfPolygons; i++) {
+    if (model->polygons[i].noSides != 3) {
+    LOG_WARN_EVERY(LOG_NON_TRIANGLES, 1, "Warning: Found non-triangle polygon (%d sides) at index %d",
+    model->polygons[i].noSides, i);
+    continue;
+    }
+
+    const Vector3f& displacement = offsets[i];
+
+    for (int j = 0; j < 3; j++) {
+    int vertIdx = model->polygons[i].v[j];
+    Vertex v = model->vertices[vertIdx];
+
+    v.x += displacement.x;
+    v.y += displacement.y;
+    v.z += displacement.z;
+
+    explodedVertices.push_back(v);
+    }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, explodedVertices.size() * sizeof(Vertex), 
+    explodedVertices.data(), GL_STATIC_DRAW);
+
+    numVertices = explodedVertices.size();
+
+    LOG_COUNT(LOG_EXPLOSION_UPDATES, 1);
+    LOG_SUMMARY(LOG_STAGE_EXPLOSION, "factor %.2f, %d triangles (%d vertices)",
+    explosionFactor, model->numberOfPolygons, numVertices);
+}
+
+
+#endif
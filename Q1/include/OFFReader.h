@@ -4,6 +4,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <vector>
+#include <atomic>
+#include "log.h"
+#include "task_system.h"
 
 typedef struct Vt {
 	float x,y,z;
@@ -27,9 +32,11 @@ typedef struct offmodel {
 }OffModel;
 
 OffModel* triangulateModel(OffModel* original) {
-    // Count the total number of triangles needed
+    // Count the total number of triangles needed, and where each polygon's go
+    std::vector<int> firstTriangle(original->numberOfPolygons);
     int totalTriangles = 0;
     for (int i = 0; i < original->numberOfPolygons; i++) {
+        firstTriangle[i] = totalTriangles;
         if (original->polygons[i].noSides == 3) {
             totalTriangles += 1;  // Already a triangle
         } else if (original->polygons[i].noSides > 3) {
@@ -52,119 +59,272 @@ OffModel* triangulateModel(OffModel* original) {
     triangulated->numberOfPolygons = totalTriangles;
     triangulated->polygons = (Polygon*)malloc(totalTriangles * sizeof(Polygon));
     
-    int triIndex = 0;
-    for (int i = 0; i < original->numberOfPolygons; i++) {
-        Polygon* poly = &original->polygons[i];
-        
-        if (poly->noSides == 3) {
-            // Copy triangle directly
-            triangulated->polygons[triIndex].noSides = 3;
-            triangulated->polygons[triIndex].v = (int*)malloc(3 * sizeof(int));
-            triangulated->polygons[triIndex].v[0] = poly->v[0];
-            triangulated->polygons[triIndex].v[1] = poly->v[1];
-            triangulated->polygons[triIndex].v[2] = poly->v[2];
-            triIndex++;
-        } 
-        else if (poly->noSides > 3) {
-            // Triangulate using fan approach
-            for (int j = 1; j < poly->noSides - 1; j++) {
+    parallelFor(g_tasks, 0, original->numberOfPolygons, taskGrain(g_tasks, original->numberOfPolygons, 4096),
+                [original, triangulated, &firstTriangle](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Polygon* poly = &original->polygons[i];
+            int triIndex = firstTriangle[i];
+            
+            if (poly->noSides == 3) {
+                // Copy triangle directly
                 triangulated->polygons[triIndex].noSides = 3;
                 triangulated->polygons[triIndex].v = (int*)malloc(3 * sizeof(int));
-                triangulated->polygons[triIndex].v[0] = poly->v[0];     // First vertex
-                triangulated->polygons[triIndex].v[1] = poly->v[j];     // Current vertex
-                triangulated->polygons[triIndex].v[2] = poly->v[j + 1]; // Next vertex
-                triIndex++;
+                triangulated->polygons[triIndex].v[0] = poly->v[0];
+                triangulated->polygons[triIndex].v[1] = poly->v[1];
+                triangulated->polygons[triIndex].v[2] = poly->v[2];
+            } 
+            else if (poly->noSides > 3) {
+                // Triangulate using fan approach
+                for (int j = 1; j < poly->noSides - 1; j++) {
+                    triangulated->polygons[triIndex].noSides = 3;
+                    triangulated->polygons[triIndex].v = (int*)malloc(3 * sizeof(int));
+                    triangulated->polygons[triIndex].v[0] = poly->v[0];     // First vertex
+                    triangulated->polygons[triIndex].v[1] = poly->v[j];     // Current vertex
+                    triangulated->polygons[triIndex].v[2] = poly->v[j + 1]; // Next vertex
+                    triIndex++;
+                }
             }
         }
-    }
+    });
     
     return triangulated;
 }
 
+int FreeOffModel(OffModel *model);
+
+// Whether the file starts with "OFF", for callers that go through many files
+// and skip the others before reading them.
+bool startsWithOffHeader(const char* OffFile) {
+    FILE* input = fopen(OffFile, "r");
+    if (!input) {
+        return false;
+    }
+    char type[4] = {0};
+    bool ok = fscanf(input, "%3s", type) == 1 && strcmp(type, "OFF") == 0;
+    fclose(input);
+    return ok;
+}
+
+// Number parsers for the body. They skip whitespace, newlines included, like
+// fscanf does, but never read past limit (the end of the line or of the
+// file) and fail when no number is left before it.
+bool parseOffInt(const char*& p, const char* limit, long& value) {
+    while (p < limit && isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (p >= limit) {
+        return false;
+    }
+    char* next;
+    value = strtol(p, &next, 10);
+    if (next == p || next > limit) {
+        return false;
+    }
+    p = next;
+    return true;
+}
+
+bool parseOffFloat(const char*& p, const char* limit, float& value) {
+    while (p < limit && isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (p >= limit) {
+        return false;
+    }
+    char* next;
+    value = strtof(p, &next);
+    if (next == p || next > limit) {
+        return false;
+    }
+    p = next;
+    return true;
+}
+
+bool parseOffVertex(const char*& p, const char* limit, Vertex& vertex) {
+    vertex.numIcidentTri = 0;
+    vertex.r = 1.0f; // Initialize color
+    vertex.g = 1.0f; // Initialize color
+    vertex.b = 1.0f; // Initialize color
+    return parseOffFloat(p, limit, vertex.x) && parseOffFloat(p, limit, vertex.y) && parseOffFloat(p, limit, vertex.z);
+}
+
+// Fails, leaving an empty polygon, on fewer than 3 sides, on more sides than
+// the rest of the input could list, and on indices outside the vertex array.
+// Anything after the indices (per-face colours) is ignored.
+bool parseOffPolygon(const char*& p, const char* limit, int vertexCount, Polygon& polygon) {
+    polygon.noSides = 0;
+    polygon.v = NULL;
+    long n;
+    if (!parseOffInt(p, limit, n)) {
+        return false;
+    }
+    // every index needs at least a separator and a digit
+    if (n < 3 || n > (limit - p) / 2) {
+        return false;
+    }
+    polygon.v = (int *) malloc(n * sizeof(int));
+    for (long j = 0; j < n; j++) {
+        long index;
+        if (!parseOffInt(p, limit, index) || index < 0 || index >= vertexCount) {
+            free(polygon.v);
+            polygon.v = NULL;
+            return false;
+        }
+        polygon.v[j] = (int)index;
+    }
+    polygon.noSides = (int)n;
+    return true;
+}
+
+// Start of every non-blank line from p on, stopping after count lines.
+void findOffLines(const char* p, const char* end, size_t count, std::vector<const char*>& lines) {
+    lines.reserve(count);
+    while (p < end && lines.size() < count) {
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = newline ? newline : end;
+        const char* q = p;
+        while (q < lineEnd && (*q == ' ' || *q == '\t' || *q == '\r')) {
+            q++;
+        }
+        if (q < lineEnd) {
+            lines.push_back(q);
+        }
+        p = lineEnd + 1;
+    }
+}
+
+const char* offLineEnd(const char* line, const char* end) {
+    const char* newline = (const char*)memchr(line, '\n', end - line);
+    return newline ? newline : end;
+}
+
+// Reads the whole file, then parses vertices and polygons line by line in
+// parallel. Files that do not hold exactly one element per line, such as
+// ones with a face wrapped onto two lines, are parsed in order instead. Invalid faces are dropped with a warning; a file that ends early
+// keeps the faces read so far. Returns NULL if the file cannot be opened, is
+// not OFF, or is missing vertices.
 OffModel* readOffFile(char * OffFile) {
     FILE * input;
     char type[4]; // Increased size to include null terminator
-    int noEdges;
-    int i, j;
-    float x, y, z;
-    int n, v;
-    int nv, np;
+    long nv, np;
     OffModel *model;
 
-    input = fopen(OffFile, "r");
+    input = fopen(OffFile, "rb");
     if (!input) {
-        printf("Error: Could not open file %s\n", OffFile);
-        exit(1);
+        LOG_ERROR("Error: Could not open file %s\n", OffFile);
+        return NULL;
+    }
+    std::vector<char> text;
+    char chunk[1 << 16];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+        text.insert(text.end(), chunk, chunk + got);
     }
+    fclose(input);
+    text.push_back('\0');
+    const char* end = &text.back();
 
     // Read and print the file type
-    fscanf(input, "%3s", type); // Read up to 3 characters
+    int typeLength = 0;
+    sscanf(text.data(), " %3s%n", type, &typeLength); // Read up to 3 characters
     type[3] = '\0'; // Ensure null termination
     printf("\nType: %s\n", type);
 
     /* First line should be OFF */
-    if (strcmp(type, "OFF") != 0) {
-        printf("Not a OFF file\n");
-        fclose(input);
-        exit(1);
+    if (typeLength == 0 || strcmp(type, "OFF") != 0) {
+        LOG_ERROR("Error: %s is not an OFF file\n", OffFile);
+        return NULL;
     }
 
-    // Read and print the number of vertices, faces, and edges
-    fscanf(input, "%d", &nv);
-    fscanf(input, "%d", &np);
-    fscanf(input, "%d", &noEdges);
-    // printf("Number of vertices: %d, Number of polygons: %d, Number of edges: %d\n", nv, np, noEdges);
+    // Read the number of vertices, faces and edges; the body starts on the
+    // line after the edge count. Every element takes at least a byte, which
+    // bounds the counts by the file size.
+    const char* p = text.data() + typeLength;
+    long edges;
+    if (!parseOffInt(p, end, nv) || !parseOffInt(p, end, np) || !parseOffInt(p, end, edges) ||
+        nv < 0 || np < 0 || nv > end - p || np > end - p) {
+        LOG_ERROR("Error: %s has a bad OFF header\n", OffFile);
+        return NULL;
+    }
+    p = offLineEnd(p, end);
 
     model = (OffModel*)malloc(sizeof(OffModel));
-    model->numberOfVertices = nv;
-    model->numberOfPolygons = np;
+    model->numberOfVertices = (int)nv;
+    model->numberOfPolygons = 0;
 
     /* Allocate required data */
     model->vertices = (Vertex *) malloc(nv * sizeof(Vertex));
     model->polygons = (Polygon *) malloc(np * sizeof(Polygon));
-	
-
-    /* Read the vertices' location */
-    // printf("Vertices:\n");
-    for (i = 0; i < nv; i++) {
-        fscanf(input, "%f %f %f", &x, &y, &z);
-        model->vertices[i].x = x;
-        model->vertices[i].y = y;
-        model->vertices[i].z = z;
-        model->vertices[i].numIcidentTri = 0;
-		model->vertices[i].r = 1.0f; // Initialize color
-		model->vertices[i].g = 1.0f; // Initialize color
-		model->vertices[i].b = 1.0f; // Initialize color
 
-        // printf("  Vertex %d: (%f, %f, %f)\n", i, x, y, z);
+    // One line more than the elements need, to tell a file that ends after
+    // them from one whose elements span more lines
+    std::vector<const char*> lines;
+    findOffLines(p, end, (size_t)nv + np + 1, lines);
 
-        if (i == 0) {
-            model->minX = model->maxX = x;
-            model->minY = model->maxY = y;
-            model->minZ = model->maxZ = z;
-        } else {
-            if (x < model->minX) model->minX = x;
-            if (x > model->maxX) model->maxX = x;
-            if (y < model->minY) model->minY = y;
-            if (y > model->maxY) model->maxY = y;
-            if (z < model->minZ) model->minZ = z;
-            if (z > model->maxZ) model->maxZ = z;
+    printf("Polygons:\n");
+    long vertexCount = 0;
+    long polygonCount = 0;
+    std::atomic<long> badVertices(0);
+    std::atomic<long> badPolygons(0);
+    if (lines.size() == (size_t)nv + np) {
+        parallelFor(g_tasks, 0, nv, taskGrain(g_tasks, nv, 8192), [model, &lines, end, &badVertices](size_t begin, size_t last) {
+            for (size_t i = begin; i < last; i++) {
+                const char* q = lines[i];
+                if (!parseOffVertex(q, offLineEnd(q, end), model->vertices[i])) {
+                    badVertices++;
+                }
+            }
+        });
+        parallelFor(g_tasks, 0, np, taskGrain(g_tasks, np, 8192), [model, &lines, end, nv, &badPolygons](size_t begin, size_t last) {
+            for (size_t i = begin; i < last; i++) {
+                const char* q = lines[nv + i];
+                if (!parseOffPolygon(q, offLineEnd(q, end), (int)nv, model->polygons[i])) {
+                    badPolygons++;
+                }
+            }
+        });
+        vertexCount = badVertices > 0 ? 0 : nv;
+        polygonCount = np;
+    } else {
+        // Elements may span lines here, so a bad face cannot be skipped:
+        // everything from it on is dropped.
+        const char* q = p;
+        while (vertexCount < nv && parseOffVertex(q, end, model->vertices[vertexCount])) {
+            vertexCount++;
+        }
+        while (vertexCount == nv && polygonCount < np && parseOffPolygon(q, end, (int)nv, model->polygons[polygonCount])) {
+            polygonCount++;
         }
+        badPolygons = np - polygonCount;
     }
+    model->numberOfPolygons = (int)polygonCount;
 
-    /* Read the polygons */
-    printf("Polygons:\n");
-    for (i = 0; i < np; i++) {
-        fscanf(input, "%d", &n);
-        model->polygons[i].noSides = n;
-        model->polygons[i].v = (int *) malloc(n * sizeof(int));
-        // printf("  Polygon %d: %d sides, vertices: ", i, n);
-        for (j = 0; j < n; j++) {
-            fscanf(input, "%d", &v);
-            model->polygons[i].v[j] = v;
-            // printf("%d ", v);
-        }
-        // printf("\n");
+    if (vertexCount < nv) {
+        LOG_ERROR("Error: %s lists %ld vertices but only %ld could be read\n", OffFile, nv, vertexCount);
+        FreeOffModel(model);
+        return NULL;
+    }
+    if (badPolygons > 0) {
+        LOG_WARN("Warning: %s: dropped %ld of %ld faces (invalid or missing)\n", OffFile, badPolygons.load(), np);
+    }
+
+    if (nv > 0) {
+        model->minX = model->maxX = model->vertices[0].x;
+        model->minY = model->maxY = model->vertices[0].y;
+        model->minZ = model->maxZ = model->vertices[0].z;
+    } else {
+        model->minX = model->maxX = 0.0f;
+        model->minY = model->maxY = 0.0f;
+        model->minZ = model->maxZ = 0.0f;
+    }
+    for (int i = 1; i < nv; i++) {
+        const Vertex& vertex = model->vertices[i];
+        if (vertex.x < model->minX) model->minX = vertex.x;
+        if (vertex.x > model->maxX) model->maxX = vertex.x;
+        if (vertex.y < model->minY) model->minY = vertex.y;
+        if (vertex.y > model->maxY) model->maxY = vertex.y;
+        if (vertex.z < model->minZ) model->minZ = vertex.z;
+        if (vertex.z > model->maxZ) model->maxZ = vertex.z;
     }
 
     float extentX = model->maxX - model->minX;
@@ -175,8 +335,6 @@ OffModel* readOffFile(char * OffFile) {
     // printf("Bounding Box: Min(%f, %f, %f), Max(%f, %f, %f)\n", model->minX, model->minY, model->minZ, model->maxX, model->maxY, model->maxZ);
     // printf("Extent: %f\n", model->extent);
 
-    fclose(input);
-    // return model;
     OffModel* triangulatedModel = triangulateModel(model);
     
     // Free the original model's polygon data as we don't need it anymore
@@ -190,88 +348,6 @@ OffModel* readOffFile(char * OffFile) {
     return triangulatedModel;
 }
 
-// OffModel* readOffFile(char * OffFile) {
-// 	FILE * input;
-// 	char type[3]; 
-// 	int noEdges;
-// 	int i,j;
-// 	float x,y,z;
-// 	int n, v;
-// 	int nv, np;
-// 	OffModel *model;
-
-
-// 	input = fopen(OffFile, "r");
-// 	if (!input) {
-// 		printf("Error: Could not open file %s\n", OffFile);
-// 		exit(1);
-// 	}
-// 	fscanf(input, "%s", type);
-// 	printf("\nType: %s\n", type);
-// 	/* First line should be OFF */
-// 	if(strncmp(type,"OFF",3)!=0) {
-// 		printf("Not a OFF file");
-// 		exit(1);
-// 	}
-// 	/* Read the no. of vertices, faces and edges */
-// 	fscanf(input, "%d", &nv);
-// 	fscanf(input, "%d", &np);
-// 	fscanf(input, "%d", &noEdges);
-
-// 	model = (OffModel*)malloc(sizeof(OffModel));
-// 	model->numberOfVertices = nv;
-// 	model->numberOfPolygons = np;
-	
-	
-// 	/* allocate required data */
-// 	model->vertices = (Vertex *) malloc(nv * sizeof(Vertex));
-// 	model->polygons = (Polygon *) malloc(np * sizeof(Polygon));
-	
-
-// 	/* Read the vertices' location*/	
-// 	for(i = 0;i < nv;i ++) {
-// 		fscanf(input, "%f %f %f", &x,&y,&z);
-// 		(model->vertices[i]).x = x;
-// 		(model->vertices[i]).y = y;
-// 		(model->vertices[i]).z = z;
-// 		(model->vertices[i]).numIcidentTri = 0;
-// 		if (i==0){
-// 			model->minX = model->maxX = x; 
-// 			model->minY = model->maxY = y; 
-// 			model->minZ = model->maxZ = z; 
-// 		} else {
-// 			if (x < model->minX) model->minX = x;
-// 			else if (x > model->maxX) model->maxX = x;
-// 			if (y < model->minY) model->minY = y;
-// 			else if (y > model->maxY) model->maxY = y;
-// 			if (z < model->minZ) model->minZ = z;
-// 			else if (z > model->maxZ) model->maxZ = z;
-// 		}
-// 	}
-
-// 	/* Read the Polygons */	
-// 	for(i = 0;i < np;i ++) {
-// 		/* No. of sides of the polygon (Eg. 3 => a triangle) */
-// 		fscanf(input, "%d", &n);
-		
-// 		(model->polygons[i]).noSides = n;
-// 		(model->polygons[i]).v = (int *) malloc(n * sizeof(int));
-// 		/* read the vertices that make up the polygon */
-// 		for(j = 0;j < n;j ++) {
-// 			fscanf(input, "%d", &v);
-// 			(model->polygons[i]).v[j] = v;
-// 		}
-// 	}
-	
-// 	float extentX = model->maxX - model->minX;
-// 	float extentY = model->maxY - model->minY;
-// 	float extentZ = model->maxZ - model->minZ;
-// 	model->extent = (extentX > extentY) ? ((extentX > extentZ) ? extentX : extentZ) : ((extentY > extentZ) ? extentY : extentZ);
-
-// 	fclose(input);
-// 	return model;
-// }
-
 int FreeOffModel(OffModel *model)
 {
 	int i;
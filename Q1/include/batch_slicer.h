@@ -0,0 +1,233 @@
+#ifndef BATCH_SLICER_H
+#define BATCH_SLICER_H
+
+#include "math_utils.h"
+#include "OFFReader.h"
+#include "normal.h"
+#include "plane.h"
+#include "mesh_slicer.h"
+#include "off_writer.h"
+#include "task_system.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <atomic>
+#include <errno.h>
+#include <sys/stat.h>
+
+// Non-interactive slicing:
+//
+//   ./sample --slice planes.txt --out dir/ [--format off|bin] [--threads n] meshes...
+//
+// planes.txt holds one plane per line as "a b c d" (a*x + b*y + c*z + d = 0);
+// blank lines and lines starting with '#' are skipped. Every segment of every
+// mesh is written to dir/<mesh>_seg<i>.off (or .seg for binary). Meshes whose
+// file names clash, such as a/part.off and b/part.off, are written as part,
+// part_2 and so on in command line order. Meshes are spread over the task
+// pool, each with its own slicer state, and the segments of a mesh are written
+// in parallel as nested tasks.
+
+struct BatchSliceOptions {
+    const char* planesPath = nullptr;
+    std::string outDir;
+    bool binary = false;
+    unsigned int threads = 0;
+    std::vector<std::string> meshes;
+};
+
+bool isBatchSliceCommand(int argc, char* argv[]) {
+    return argc > 1 && strcmp(argv[1], "--slice") == 0;
+}
+
+bool readPlanesFile(const char* path, std::vector<Plane>& planes) {
+    FILE* input = fopen(path, "r");
+    if (!input) {
+        fprintf(stderr, "Error: Could not open planes file %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), input)) {
+        lineNumber++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+            continue;
+        }
+
+        Plane plane;
+        if (sscanf(p, "%f %f %f %f", &plane.a, &plane.b, &plane.c, &plane.d) != 4) {
+            fprintf(stderr, "Error: %s:%d is not a plane (expected \"a b c d\")\n", path, lineNumber);
+            fclose(input);
+            return false;
+        }
+
+        float magnitude = sqrtf(plane.a*plane.a + plane.b*plane.b + plane.c*plane.c);
+        if (magnitude <= 0.0001f) {
+            fprintf(stderr, "Warning: %s:%d has a zero normal, skipping\n", path, lineNumber);
+            continue;
+        }
+        plane.a /= magnitude;
+        plane.b /= magnitude;
+        plane.c /= magnitude;
+        plane.d /= magnitude;
+        plane.enabled = true;
+        planes.push_back(plane);
+    }
+
+    fclose(input);
+    return true;
+}
+
+bool parseBatchSliceOptions(int argc, char* argv[], BatchSliceOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--slice") == 0 && hasValue) {
+            options.planesPath = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            options.outDir = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+            options.binary = strcmp(argv[++i], "bin") == 0;
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = std::max(0, atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return false;
+        } else {
+            options.meshes.push_back(argv[i]);
+        }
+    }
+
+    if (!options.planesPath || options.outDir.empty() || options.meshes.empty()) {
+        fprintf(stderr, "Usage: %s --slice planes.txt --out dir/ [--format off|bin] [--threads n] meshes...\n", argv[0]);
+        return false;
+    }
+    while (options.outDir.size() > 1 && options.outDir[options.outDir.size() - 1] == '/') {
+        options.outDir.erase(options.outDir.size() - 1);
+    }
+    return true;
+}
+
+std::string meshBaseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+// Output name of every mesh: its base name, with _2, _3, ... appended to names
+// already taken so that no two meshes write the same files.
+std::vector<std::string> batchOutputNames(const std::vector<std::string>& meshes) {
+    std::vector<std::string> names;
+    std::set<std::string> taken;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        std::string base = meshBaseName(meshes[i]);
+        std::string name = base;
+        for (int n = 2; taken.count(name); n++) {
+            name = base + "_" + std::to_string(n);
+        }
+        if (name != base) {
+            fprintf(stderr, "Warning: %s is already used by an earlier mesh, writing %s as %s\n",
+                    base.c_str(), meshes[i].c_str(), name.c_str());
+        }
+        taken.insert(name);
+        names.push_back(name);
+    }
+    return names;
+}
+
+// Slices one mesh with a private state and writes its segments as
+// <outputName>_seg<i>. Returns the number of segments written, or -1 if the
+// mesh could not be processed.
+int sliceMeshToDisk(const std::string& meshPath, const std::string& outputName, const std::vector<Plane>& planes,
+                    const BatchSliceOptions& options) {
+    std::vector<char> path(meshPath.begin(), meshPath.end());
+    path.push_back('\0');
+
+    FILE* input = fopen(path.data(), "r");
+    if (!input) {
+        fprintf(stderr, "Skipping %s: %s\n", meshPath.c_str(), strerror(errno));
+        return -1;
+    }
+    fclose(input);
+    if (!startsWithOffHeader(path.data())) {
+        fprintf(stderr, "Skipping %s: not a plain OFF file\n", meshPath.c_str());
+        return -1;
+    }
+
+    OffModel* model = readOffFile(path.data());
+    if (!model) {
+        fprintf(stderr, "Skipping %s: could not be read\n", meshPath.c_str());
+        return -1;
+    }
+    calculateVertexNormals(model);
+
+    MeshSlicerState state;
+    state.model = model;
+    sliceWithPlanes(state, planes);
+
+    std::string base = options.outDir + "/" + outputName;
+    std::atomic<bool> failed(false);
+    parallelFor(g_tasks, 0, state.segments.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), "_seg%02zu.%s", i, options.binary ? "seg" : "off");
+            std::string segmentPath = base + suffix;
+
+            bool ok = options.binary
+                ? writeSegmentBinary(segmentPath.c_str(), state, state.segments[i])
+                : writeSegmentOff(segmentPath.c_str(), state, state.segments[i]);
+            if (!ok) {
+                fprintf(stderr, "Error: Failed writing %s\n", segmentPath.c_str());
+                failed = true;
+            }
+        }
+    }, &failed);
+
+    FreeOffModel(model);
+    return failed ? -1 : (int)state.segments.size();
+}
+
+int runBatchSlicing(int argc, char* argv[]) {
+    BatchSliceOptions options;
+    if (!parseBatchSliceOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Plane> planes;
+    if (!readPlanesFile(options.planesPath, planes)) {
+        return 1;
+    }
+
+    if (mkdir(options.outDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Could not create output directory %s\n", options.outDir.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> outputNames = batchOutputNames(options.meshes);
+    startTaskSystem(g_tasks, options.threads);
+
+    std::atomic<int> failed(0);
+    std::atomic<int> segmentsWritten(0);
+
+    parallelFor(g_tasks, 0, options.meshes.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            int written = sliceMeshToDisk(options.meshes[i], outputNames[i], planes, options);
+            if (written < 0) {
+                failed++;
+            } else {
+                segmentsWritten += written;
+                fprintf(stderr, "%s: %d segments\n", options.meshes[i].c_str(), written);
+            }
+        }
+    });
+
+    fprintf(stderr, "Sliced %zu meshes with %zu planes into %d segments (%d failed)\n",
+            options.meshes.size() - failed, planes.size(), segmentsWritten.load(), failed.load());
+    return failed > 0 ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "math_utils.h"
+#include <vector>
+#include <algorithm>
+#include <float.h>
+
+// Bounding volume hierarchy over triangles, for CPU ray picking. Nodes are 32
+// bytes: a box plus either the index of the left child (the right child is
+// the next node) or, for leaves, a range of the BVH's own triangle list,
+// which is reordered at build time so every leaf's triangles are contiguous.
+// Built top down with a binned surface area heuristic. refitBVH updates the
+// boxes after triangles move, keeping the tree.
+
+const int BVH_BINS = 12;
+const unsigned int BVH_MAX_LEAF = 8;
+const int BVH_MAX_SAH_DEPTH = 48;  // deeper nodes are halved, bounding the traversal stack
+const int BVH_STACK = 128;
+
+struct BVHNode {
+    float min[3];
+    unsigned int leftOrFirst;  // left child for inner nodes, first slot for leaves
+    float max[3];
+    unsigned int count;        // triangles in a leaf, 0 for inner nodes
+};
+
+struct BVH {
+    std::vector<BVHNode> nodes;
+    std::vector<unsigned int> ids;   // caller's triangle index per slot
+    std::vector<Vector3f> vertices;  // three per slot
+};
+
+struct PickRay {
+    Vector3f origin;
+    Vector3f direction;
+};
+
+struct BVHHit {
+    float t = FLT_MAX;
+    unsigned int triangle = 0;  // caller's triangle index
+};
+
+struct BVHBounds {
+    float min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    void grow(const float p[3]) {
+        for (int a = 0; a < 3; a++) {
+            min[a] = std::min(min[a], p[a]);
+            max[a] = std::max(max[a], p[a]);
+        }
+    }
+    void grow(const BVHBounds& b) {
+        for (int a = 0; a < 3; a++) {
+            min[a] = std::min(min[a], b.min[a]);
+            max[a] = std::max(max[a], b.max[a]);
+        }
+    }
+    float area() const {
+        float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+        return (dx < 0.0f) ? 0.0f : dx * dy + dy * dz + dz * dx;
+    }
+};
+
+void setNodeBounds(BVHNode& node, const BVHBounds& bounds) {
+    for (int a = 0; a < 3; a++) {
+        node.min[a] = bounds.min[a];
+        node.max[a] = bounds.max[a];
+    }
+}
+
+// Builds over triangleCount triangles given as vertex indices. Positions are
+// three floats every stride bytes, so vertex structs can be used in place.
+void buildBVH(BVH& bvh, const void* positions, size_t stride, const unsigned int* indices, size_t triangleCount) {
+    bvh.nodes.clear();
+    bvh.ids.resize(triangleCount);
+    bvh.vertices.resize(triangleCount * 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    const char* base = (const char*)positions;
+    std::vector<BVHBounds> boxes(triangleCount);
+    std::vector<float> centroids(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount; i++) {
+        bvh.ids[i] = i;
+        for (int j = 0; j < 3; j++) {
+            boxes[i].grow((const float*)(base + indices[i * 3 + j] * stride));
+        }
+        for (int a = 0; a < 3; a++) {
+            centroids[i * 3 + a] = 0.5f * (boxes[i].min[a] + boxes[i].max[a]);
+        }
+    }
+
+    bvh.nodes.push_back(BVHNode());
+    bvh.nodes[0].leftOrFirst = 0;
+    bvh.nodes[0].count = triangleCount;
+
+    std::vector<std::pair<unsigned int, int> > stack(1, std::make_pair(0u, 0));  // node, depth
+    while (!stack.empty()) {
+        unsigned int nodeIndex = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+        unsigned int first = bvh.nodes[nodeIndex].leftOrFirst;
+        unsigned int count = bvh.nodes[nodeIndex].count;
+
+        BVHBounds bounds, centroidBounds;
+        for (unsigned int i = first; i < first + count; i++) {
+            bounds.grow(boxes[bvh.ids[i]]);
+            centroidBounds.grow(&centroids[bvh.ids[i] * 3]);
+        }
+        setNodeBounds(bvh.nodes[nodeIndex], bounds);
+        if (count <= 2) {
+            continue;
+        }
+
+        // Cheapest bin boundary over all three axes
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = count * bounds.area();
+        for (int axis = 0; axis < 3 && depth < BVH_MAX_SAH_DEPTH; axis++) {
+            float lo = centroidBounds.min[axis];
+            float extent = centroidBounds.max[axis] - lo;
+            if (extent <= 0.0f) {
+                continue;
+            }
+            float scale = BVH_BINS / extent;
+
+            BVHBounds binBounds[BVH_BINS];
+            unsigned int binCounts[BVH_BINS] = {0};
+            for (unsigned int i = first; i < first + count; i++) {
+                unsigned int id = bvh.ids[i];
+                int bin = std::min(BVH_BINS - 1, (int)((centroids[id * 3 + axis] - lo) * scale));
+                binCounts[bin]++;
+                binBounds[bin].grow(boxes[id]);
+            }
+
+            float leftArea[BVH_BINS - 1];
+            unsigned int leftCount[BVH_BINS - 1];
+            BVHBounds left;
+            unsigned int sum = 0;
+            for (int b = 0; b < BVH_BINS - 1; b++) {
+                left.grow(binBounds[b]);
+                sum += binCounts[b];
+                leftArea[b] = left.area();
+                leftCount[b] = sum;
+            }
+            BVHBounds right;
+            sum = 0;
+            for (int b = BVH_BINS - 1; b > 0; b--) {
+                right.grow(binBounds[b]);
+                sum += binCounts[b];
+                if (leftCount[b - 1] == 0 || sum == 0) {
+                    continue;
+                }
+                float cost = leftCount[b - 1] * leftArea[b - 1] + sum * right.area();
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        if (bestAxis < 0) {
+            if (count <= BVH_MAX_LEAF) {
+                continue;
+            }
+            // Too many to leave in one leaf and no split pays off, which
+            // happens with stacked centroids, or the tree is already deep:
+            // halve along the longest axis.
+            bestAxis = 0;
+            for (int a = 1; a < 3; a++) {
+                if (bounds.max[a] - bounds.min[a] > bounds.max[bestAxis] - bounds.min[bestAxis]) {
+                    bestAxis = a;
+                }
+            }
+            std::nth_element(bvh.ids.begin() + first, bvh.ids.begin() + first + count / 2, bvh.ids.begin() + first + count,
+                             [&](unsigned int a, unsigned int b) {
+                                 return centroids[a * 3 + bestAxis] < centroids[b * 3 + bestAxis];
+                             });
+            bestSplit = -1;
+        }
+
+        unsigned int leftCount = count / 2;
+        if (bestSplit >= 0) {
+            float lo = centroidBounds.min[bestAxis];
+            float scale = BVH_BINS / (centroidBounds.max[bestAxis] - lo);
+            unsigned int* begin = &bvh.ids[first];
+            unsigned int* middle = std::partition(begin, begin + count, [&](unsigned int id) {
+                return std::min(BVH_BINS - 1, (int)((centroids[id * 3 + bestAxis] - lo) * scale)) < bestSplit;
+            });
+            leftCount = middle - begin;
+        }
+
+        unsigned int leftIndex = bvh.nodes.size();
+        bvh.nodes.push_back(BVHNode());
+        bvh.nodes.push_back(BVHNode());
+        bvh.nodes[leftIndex].leftOrFirst = first;
+        bvh.nodes[leftIndex].count = leftCount;
+        bvh.nodes[leftIndex + 1].leftOrFirst = first + leftCount;
+        bvh.nodes[leftIndex + 1].count = count - leftCount;
+        bvh.nodes[nodeIndex].leftOrFirst = leftIndex;
+        bvh.nodes[nodeIndex].count = 0;
+        stack.push_back(std::make_pair(leftIndex, depth + 1));
+        stack.push_back(std::make_pair(leftIndex + 1, depth + 1));
+    }
+
+    for (size_t i = 0; i < triangleCount; i++) {
+        for (int j = 0; j < 3; j++) {
+            const float* p = (const float*)(base + indices[bvh.ids[i] * 3 + j] * stride);
+            bvh.vertices[i * 3 + j] = Vector3f(p[0], p[1], p[2]);
+        }
+    }
+}
+
+// Recomputes every box from bvh.vertices. Children always come after their
+// parent, so one backwards pass is enough.
+void refitBVH(BVH& bvh) {
+    for (size_t n = bvh.nodes.size(); n-- > 0;) {
+        BVHNode& node = bvh.nodes[n];
+        BVHBounds bounds;
+        if (node.count > 0) {
+            for (unsigned int i = node.leftOrFirst * 3; i < (node.leftOrFirst + node.count) * 3; i++) {
+                bounds.grow(&bvh.vertices[i].x);
+            }
+        } else {
+            for (int c = 0; c < 2; c++) {
+                const BVHNode& child = bvh.nodes[node.leftOrFirst + c];
+                bounds.grow(child.min);
+                bounds.grow(child.max);
+            }
+        }
+        setNodeBounds(node, bounds);
+    }
+}
+
+// Slab test; returns the entry distance, or FLT_MAX on a miss or when the
+// box starts beyond maxT.
+float intersectBVHNode(const BVHNode& node, const PickRay& ray, const float invDir[3], float maxT) {
+    float tMin = 0.0f, tMax = maxT;
+    const float* origin = &ray.origin.x;
+    for (int a = 0; a < 3; a++) {
+        float t0 = (node.min[a] - origin[a]) * invDir[a];
+        float t1 = (node.max[a] - origin[a]) * invDir[a];
+        tMin = std::max(tMin, std::min(t0, t1));
+        tMax = std::min(tMax, std::max(t0, t1));
+    }
+    return tMin <= tMax ? tMin : FLT_MAX;
+}
+
+// Möller-Trumbore, both faces.
+bool intersectTriangle(const PickRay& ray, const Vector3f& v0, const Vector3f& v1, const Vector3f& v2, float& t) {
+    Vector3f e1 = v1 - v0;
+    Vector3f e2 = v2 - v0;
+    Vector3f p = ray.direction.Cross(e2);
+    float det = e1.Dot(p);
+    if (fabsf(det) < 1e-12f) {
+        return false;
+    }
+    float invDet = 1.0f / det;
+    Vector3f s = ray.origin - v0;
+    float u = s.Dot(p) * invDet;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    Vector3f q = s.Cross(e1);
+    float v = ray.direction.Dot(q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    t = e2.Dot(q) * invDet;
+    return t > 0.0f;
+}
+
+// Closest hit in front of the ray origin nearer than hit.t; updates hit.
+bool intersectBVH(const BVH& bvh, const PickRay& ray, BVHHit& hit) {
+    if (bvh.nodes.empty()) {
+        return false;
+    }
+    float invDir[3] = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    bool found = false;
+
+    unsigned int stack[BVH_STACK];
+    int top = 0;
+    if (intersectBVHNode(bvh.nodes[0], ray, invDir, hit.t) == FLT_MAX) {
+        return false;
+    }
+    stack[top++] = 0;
+    while (top > 0) {
+        const BVHNode& node = bvh.nodes[stack[--top]];
+        if (node.count > 0) {
+            for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                float t;
+                if (intersectTriangle(ray, bvh.vertices[i * 3], bvh.vertices[i * 3 + 1], bvh.vertices[i * 3 + 2], t) &&
+                    t < hit.t) {
+                    hit.t = t;
+                    hit.triangle = bvh.ids[i];
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Push the farther child first so the nearer one is searched first
+        unsigned int left = node.leftOrFirst;
+        float tLeft = intersectBVHNode(bvh.nodes[left], ray, invDir, hit.t);
+        float tRight = intersectBVHNode(bvh.nodes[left + 1], ray, invDir, hit.t);
+        if (tLeft > tRight) {
+            std::swap(tLeft, tRight);
+            left++;
+            if (tRight != FLT_MAX) {
+                stack[top++] = left - 1;
+            }
+        } else if (tRight != FLT_MAX) {
+            stack[top++] = left + 1;
+        }
+        if (tLeft != FLT_MAX) {
+            stack[top++] = left;
+        }
+    }
+    return found;
+}
+
+#endif
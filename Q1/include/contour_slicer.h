@@ -0,0 +1,271 @@
+#ifndef CONTOUR_SLICER_H
+#define CONTOUR_SLICER_H
+
+#include "math_utils.h"
+#include "OFFReader.h"
+#include "plane.h"
+#include <vector>
+#include <algorithm>
+#include "task_system.h"
+#include <stdint.h>
+
+// Cross-section contours of a mesh at many equally spaced parallel planes.
+// Unlike sliceWithPlanes this never builds segment meshes: each layer only
+// gets the closed polylines where the surface crosses its plane.
+
+struct ContourPolyline {
+    size_t firstPoint;
+    size_t pointCount;
+    bool closed;
+};
+
+struct ContourLayer {
+    Plane plane;
+    std::vector<Vector3f> points;
+    std::vector<ContourPolyline> polylines;
+};
+
+struct ContourTriangle {
+    float minHeight;
+    float maxHeight;
+    int v[3];
+};
+
+// One plane crossing of a triangle. The crossed edges are named by their
+// vertex pair, so neighbouring triangles agree on the shared end point. The
+// segment runs from the edge the surface enters the positive side through to
+// the edge it leaves by, which orients every loop the same way.
+struct ContourSegment {
+    uint64_t from;
+    uint64_t to;
+    Vector3f fromPoint;
+    Vector3f toPoint;
+};
+
+uint64_t contourEdgeKey(int a, int b) {
+    uint32_t lo = std::min(a, b), hi = std::max(a, b);
+    return ((uint64_t)lo << 32) | hi;
+}
+
+// Same interpolation as intersectEdge, but on heights that are
+// already known and always from the lower vertex index so both triangles
+// sharing the edge produce the same point.
+Vector3f contourEdgePoint(const OffModel* model, const std::vector<float>& heights, int a, int b, float height) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    const Vertex& v1 = model->vertices[a];
+    const Vertex& v2 = model->vertices[b];
+    float t = (height - heights[a]) / (heights[b] - heights[a]);
+    return Vector3f(v1.x + t * (v2.x - v1.x), v1.y + t * (v2.y - v1.y), v1.z + t * (v2.z - v1.z));
+}
+
+// A vertex counts as positive only when it is strictly above the plane, the
+// same rule splitRegion uses. Vertices lying exactly on the plane then
+// never produce zero-length or doubled segments.
+bool intersectContourTriangle(const OffModel* model, const std::vector<float>& heights,
+                              const ContourTriangle& tri, float height, ContourSegment& segment) {
+    bool positive[3];
+    for (int i = 0; i < 3; i++) {
+        positive[i] = heights[tri.v[i]] > height;
+    }
+    if (positive[0] == positive[1] && positive[1] == positive[2]) {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        int a = tri.v[i], b = tri.v[(i + 1) % 3];
+        if (positive[i] == positive[(i + 1) % 3]) {
+            continue;
+        }
+
+        if (positive[(i + 1) % 3]) {
+            segment.from = contourEdgeKey(a, b);
+            segment.fromPoint = contourEdgePoint(model, heights, a, b, height);
+        } else {
+            segment.to = contourEdgeKey(a, b);
+            segment.toPoint = contourEdgePoint(model, heights, a, b, height);
+        }
+    }
+    return true;
+}
+
+// Joins the segments of one layer end to start into polylines. Chains that
+// start at an edge nothing leads into are open (a hole or a non-manifold
+// edge in the mesh); everything left afterwards is a closed loop.
+void chainContourSegments(std::vector<ContourSegment>& segments, ContourLayer& layer) {
+    if (segments.empty()) {
+        return;
+    }
+
+    std::sort(segments.begin(), segments.end(),
+              [](const ContourSegment& l, const ContourSegment& r) { return l.from < r.from; });
+
+    std::vector<uint64_t> ends(segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        ends[i] = segments[i].to;
+    }
+    std::sort(ends.begin(), ends.end());
+
+    std::vector<bool> used(segments.size(), false);
+
+    auto findNext = [&](uint64_t key) -> long {
+        auto it = std::lower_bound(segments.begin(), segments.end(), key,
+                                   [](const ContourSegment& s, uint64_t k) { return s.from < k; });
+        for (; it != segments.end() && it->from == key; ++it) {
+            size_t index = it - segments.begin();
+            if (!used[index]) {
+                return (long)index;
+            }
+        }
+        return -1;
+    };
+
+    auto walk = [&](size_t start) {
+        ContourPolyline polyline;
+        polyline.firstPoint = layer.points.size();
+        polyline.closed = false;
+
+        long current = (long)start;
+        while (current >= 0) {
+            const ContourSegment& segment = segments[current];
+            used[current] = true;
+            layer.points.push_back(segment.fromPoint);
+
+            if (segment.to == segments[start].from) {
+                polyline.closed = true;
+                break;
+            }
+
+            long next = findNext(segment.to);
+            if (next < 0) {
+                layer.points.push_back(segment.toPoint);
+            }
+            current = next;
+        }
+
+        polyline.pointCount = layer.points.size() - polyline.firstPoint;
+        layer.polylines.push_back(polyline);
+    };
+
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!used[i] && !std::binary_search(ends.begin(), ends.end(), segments[i].from)) {
+            walk(i);
+        }
+    }
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!used[i]) {
+            walk(i);
+        }
+    }
+}
+
+// Extracts layerCount contours perpendicular to normal, spaced evenly over
+// the mesh and offset half a layer from either end. Triangles are sorted by
+// their lowest point along the normal and each task of g_tasks sweeps a block
+// of consecutive layers, keeping only the triangles that span the current
+// plane.
+std::vector<ContourLayer> extractContours(const OffModel* model, Vector3f normal, int layerCount) {
+    std::vector<ContourLayer> layers;
+    if (!model || layerCount <= 0 || model->numberOfVertices == 0) {
+        return layers;
+    }
+
+    if (normal.length() < 0.0001f) {
+        normal = Vector3f(0.0f, 0.0f, 1.0f);
+    }
+    normal.Normalize();
+
+    std::vector<float> heights(model->numberOfVertices);
+    float minHeight = 0.0f, maxHeight = 0.0f;
+    for (int i = 0; i < model->numberOfVertices; i++) {
+        const Vertex& v = model->vertices[i];
+        heights[i] = normal.x * v.x + normal.y * v.y + normal.z * v.z;
+        if (i == 0 || heights[i] < minHeight) minHeight = heights[i];
+        if (i == 0 || heights[i] > maxHeight) maxHeight = heights[i];
+    }
+
+    std::vector<ContourTriangle> triangles;
+    triangles.reserve(model->numberOfPolygons);
+    for (int i = 0; i < model->numberOfPolygons; i++) {
+        const Polygon& poly = model->polygons[i];
+        if (poly.noSides != 3) {
+            continue;
+        }
+
+        ContourTriangle tri;
+        for (int j = 0; j < 3; j++) {
+            tri.v[j] = poly.v[j];
+        }
+        tri.minHeight = std::min(heights[tri.v[0]], std::min(heights[tri.v[1]], heights[tri.v[2]]));
+        tri.maxHeight = std::max(heights[tri.v[0]], std::max(heights[tri.v[1]], heights[tri.v[2]]));
+        triangles.push_back(tri);
+    }
+    std::sort(triangles.begin(), triangles.end(),
+              [](const ContourTriangle& l, const ContourTriangle& r) { return l.minHeight < r.minHeight; });
+
+    float spacing = (maxHeight - minHeight) / layerCount;
+    layers.resize(layerCount);
+    for (int i = 0; i < layerCount; i++) {
+        float height = minHeight + (i + 0.5f) * spacing;
+        layers[i].plane.a = normal.x;
+        layers[i].plane.b = normal.y;
+        layers[i].plane.c = normal.z;
+        layers[i].plane.d = -height;
+        layers[i].plane.enabled = true;
+    }
+
+    // Blocks are small enough to balance uneven layers across threads, and
+    // large enough that rebuilding the active list per block stays cheap.
+    int blockSize = std::max(1, layerCount / (int)(taskThreadCount(g_tasks) * 8));
+    int blockCount = (layerCount + blockSize - 1) / blockSize;
+
+    parallelFor(g_tasks, 0, blockCount, 1, [&](size_t firstBlock, size_t lastBlock) {
+        std::vector<size_t> active;
+        std::vector<ContourSegment> segments;
+
+        for (int block = (int)firstBlock; block < (int)lastBlock; block++) {
+            int firstLayer = block * blockSize;
+            int lastLayer = std::min(layerCount, firstLayer + blockSize);
+
+            float firstHeight = -layers[firstLayer].plane.d;
+            size_t pending = std::upper_bound(triangles.begin(), triangles.end(), firstHeight,
+                                              [](float h, const ContourTriangle& t) { return h < t.minHeight; }) - triangles.begin();
+            active.clear();
+            for (size_t i = 0; i < pending; i++) {
+                if (triangles[i].maxHeight >= firstHeight) {
+                    active.push_back(i);
+                }
+            }
+
+            for (int layerIndex = firstLayer; layerIndex < lastLayer; layerIndex++) {
+                float height = -layers[layerIndex].plane.d;
+                while (pending < triangles.size() && triangles[pending].minHeight <= height) {
+                    active.push_back(pending++);
+                }
+
+                segments.clear();
+                size_t kept = 0;
+                for (size_t i = 0; i < active.size(); i++) {
+                    const ContourTriangle& tri = triangles[active[i]];
+                    if (tri.maxHeight < height) {
+                        continue;
+                    }
+                    active[kept++] = active[i];
+
+                    ContourSegment segment;
+                    if (intersectContourTriangle(model, heights, tri, height, segment)) {
+                        segments.push_back(segment);
+                    }
+                }
+                active.resize(kept);
+
+                chainContourSegments(segments, layers[layerIndex]);
+            }
+        }
+    });
+
+    return layers;
+}
+
+#endif
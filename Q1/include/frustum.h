@@ -0,0 +1,98 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "math_utils.h"
+#include "plane.h"
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+// View frustum as six inward-facing planes, taken straight from a clip-space
+// transform (Gribb & Hartmann). Pass projection * view * world and the planes
+// come out in that object's space, so bounds can be tested untransformed.
+struct Frustum {
+    Plane planes[6];  // left, right, bottom, top, near, far
+};
+
+void extractFrustum(const Matrix4f& clip, Frustum& frustum) {
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+        Plane& plane = frustum.planes[i];
+        plane.a = clip.m[3][0] + sign * clip.m[row][0];
+        plane.b = clip.m[3][1] + sign * clip.m[row][1];
+        plane.c = clip.m[3][2] + sign * clip.m[row][2];
+        plane.d = clip.m[3][3] + sign * clip.m[row][3];
+        plane.enabled = true;
+
+        float magnitude = sqrtf(plane.a*plane.a + plane.b*plane.b + plane.c*plane.c);
+        if (magnitude > 0.0f) {
+            plane.a /= magnitude;
+            plane.b /= magnitude;
+            plane.c /= magnitude;
+            plane.d /= magnitude;
+        }
+    }
+}
+
+// Conservative: may keep spheres near a frustum corner that are outside.
+bool sphereInFrustum(const Frustum& frustum, const Vector3f& center, float radius) {
+    for (int i = 0; i < 6; i++) {
+        const Plane& plane = frustum.planes[i];
+        if (plane.a * center.x + plane.b * center.y + plane.c * center.z + plane.d < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Spheres as separate coordinate arrays, for testing many at once.
+struct SpheresSoA {
+    std::vector<float> x, y, z, radius;
+    std::vector<float> distances;  // scratch, 8 arrays of one distance per sphere
+    
+    void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        radius.resize(count);
+    }
+};
+
+// Batch sphereInFrustum. The plane equations go in as the rows of two
+// matrices, so every sphere's six plane distances come from two batch
+// transforms of the centres.
+void spheresInFrustum(const Frustum& frustum, SpheresSoA& spheres, std::vector<unsigned char>& visible) {
+    size_t count = spheres.x.size();
+    spheres.distances.resize(count * 8);
+    visible.resize(count);
+    
+    Matrix4f planeRows[2];
+    for (int i = 0; i < 8; i++) {
+        const Plane& plane = frustum.planes[std::min(i, 5)];
+        float* row = planeRows[i / 4].m[i % 4];
+        row[0] = plane.a;
+        row[1] = plane.b;
+        row[2] = plane.c;
+        row[3] = plane.d;
+    }
+    
+    float* d = spheres.distances.data();
+    for (int half = 0; half < 2; half++) {
+        float* base = d + half * 4 * count;
+        TransformSoA soa = {spheres.x.data(), spheres.y.data(), spheres.z.data(),
+                            base, base + count, base + 2 * count, base + 3 * count};
+        transformPointsSoA(planeRows[half], soa, 0, count);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        float nearest = d[i];
+        for (int plane = 1; plane < 6; plane++) {
+            nearest = std::min(nearest, d[plane * count + i]);
+        }
+        visible[i] = nearest >= -spheres.radius[i];
+    }
+}
+
+#endif
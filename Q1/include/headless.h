@@ -0,0 +1,209 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <GL/glew.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// Offscreen rendering for frame benchmarks on machines without a display:
+//
+//   ./sample --headless [--frames n] [--size WxH] [--planes planes.txt]
+//            [--preview] [--no-cull] [--lights n] [--tiled] [--explode f] [--csv file] [--dump dir] [--dump-every n] mesh.off
+//
+// An EGL surfaceless context (Mesa's llvmpipe works) renders into an FBO the
+// size of the requested window. Linux only; elsewhere the mode reports that it
+// is unavailable.
+
+struct HeadlessOptions {
+    const char* meshPath = nullptr;
+    const char* planesPath = nullptr;
+    const char* csvPath = nullptr;
+    std::string dumpDir;
+    int frames = 120;
+    int dumpEvery = 1;
+    int width = 800;
+    int height = 600;
+    bool preview = false;
+    bool culling = true;
+    bool tiledLighting = false;
+    int lights = 0;
+    float explosion = 0.0f;
+};
+
+struct HeadlessContext {
+    GLuint fbo = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+#ifdef __linux__
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#endif
+};
+
+bool isHeadlessCommand(int argc, char* argv[]) {
+    return argc > 1 && strcmp(argv[1], "--headless") == 0;
+}
+
+bool parseHeadlessOptions(int argc, char* argv[], HeadlessOptions& options) {
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+            options.frames = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--size") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 ||
+                options.width <= 0 || options.height <= 0) {
+                fprintf(stderr, "Error: --size expects WxH\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--planes") == 0 && hasValue) {
+            options.planesPath = argv[++i];
+        } else if (strcmp(argv[i], "--preview") == 0) {
+            options.preview = true;
+        } else if (strcmp(argv[i], "--lights") == 0 && hasValue) {
+            options.lights = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--tiled") == 0) {
+            options.tiledLighting = true;
+        } else if (strcmp(argv[i], "--no-cull") == 0) {
+            options.culling = false;
+        } else if (strcmp(argv[i], "--explode") == 0 && hasValue) {
+            options.explosion = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--dump") == 0 && hasValue) {
+            options.dumpDir = argv[++i];
+        } else if (strcmp(argv[i], "--dump-every") == 0 && hasValue) {
+            options.dumpEvery = std::max(1, atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return false;
+        } else {
+            options.meshPath = argv[i];
+        }
+    }
+
+    if (!options.meshPath) {
+        fprintf(stderr, "Usage: %s --headless [--frames n] [--size WxH] [--planes planes.txt] [--preview] "
+                        "[--no-cull] [--lights n] [--tiled] [--explode f] [--csv file] [--dump dir] [--dump-every n] mesh.off\n", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+#ifdef __linux__
+bool createHeadlessContext(HeadlessContext& headless, int width, int height) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        headless.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (headless.display == EGL_NO_DISPLAY) {
+        headless.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major, minor;
+    if (headless.display == EGL_NO_DISPLAY || !eglInitialize(headless.display, &major, &minor)) {
+        fprintf(stderr, "Error: Could not initialize EGL\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "Error: EGL has no desktop OpenGL\n");
+        return false;
+    }
+
+    // No config and no surface: everything is drawn into the FBO below.
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    headless.context = eglCreateContext(headless.display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    if (headless.context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless.context)) {
+        fprintf(stderr, "Error: Could not create a surfaceless OpenGL 3.3 context (EGL 0x%x)\n", eglGetError());
+        return false;
+    }
+
+    // GLEW may complain that there is no GLX display; the GL entry points it
+    // needs are loaded regardless.
+    glewExperimental = GL_TRUE;
+    glewInit();
+    glGetError();
+
+    glGenFramebuffers(1, &headless.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless.fbo);
+
+    glGenRenderbuffers(1, &headless.colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless.colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless.colorBuffer);
+
+    glGenRenderbuffers(1, &headless.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless.depthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Error: Offscreen framebuffer is incomplete\n");
+        return false;
+    }
+    glViewport(0, 0, width, height);
+
+    printf("Headless GL: %s on %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+    return true;
+}
+
+void destroyHeadlessContext(HeadlessContext& headless) {
+    if (headless.context != EGL_NO_CONTEXT) {
+        glDeleteFramebuffers(1, &headless.fbo);
+        glDeleteRenderbuffers(1, &headless.colorBuffer);
+        glDeleteRenderbuffers(1, &headless.depthBuffer);
+        eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(headless.display, headless.context);
+    }
+    if (headless.display != EGL_NO_DISPLAY) {
+        eglTerminate(headless.display);
+    }
+    headless.context = EGL_NO_CONTEXT;
+    headless.display = EGL_NO_DISPLAY;
+}
+#else
+bool createHeadlessContext(HeadlessContext& headless, int width, int height) {
+    fprintf(stderr, "Error: Headless rendering needs EGL and is only available on Linux\n");
+    return false;
+}
+
+void destroyHeadlessContext(HeadlessContext& headless) {
+}
+#endif
+
+// Reads back the FBO and writes it as a binary PPM, top row first.
+bool writeFramePPM(const char* path, int width, int height) {
+    std::vector<unsigned char> pixels((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    FILE* output = fopen(path, "wb");
+    if (!output) {
+        fprintf(stderr, "Error: Could not write %s\n", path);
+        return false;
+    }
+    fprintf(output, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--) {
+        fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, output);
+    }
+    bool ok = !ferror(output);
+    fclose(output);
+    return ok;
+}
+
+#endif
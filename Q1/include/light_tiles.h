@@ -0,0 +1,170 @@
+#ifndef LIGHT_TILES_H
+#define LIGHT_TILES_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "math_utils.h"
+#include "frustum.h"
+#include "uniform_buffers.h"
+
+// Tiled light assignment. The screen is cut into LIGHT_TILE_SIZE pixel tiles
+// and every light's range is projected to the rectangle of tiles it can
+// touch, so the fragment shader only loops over the lights of its own tile.
+// Lights without a range (radius 0) go into every tile. The result lives in
+// two buffer textures: one (offset, count) pair per tile and the flat list of
+// light indices they point into.
+
+const int LIGHT_TILE_SIZE = 32;
+
+struct LightTiles {
+    GLuint tileBuffer = 0, tileTexture = 0;
+    GLuint indexBuffer = 0, indexTexture = 0;
+    size_t tileCapacity = 0, indexCapacity = 0;
+    int tilesX = 0, tilesY = 0;
+    std::vector<GLuint> tiles;    // offset, count per tile
+    std::vector<GLuint> indices;
+    std::vector<int> rects;       // x0, y0, x1, y1 in tiles per light, x0 < 0 when culled
+    double lastAssignMs = 0.0;
+    float averageLightsPerTile = 0.0f;
+};
+
+// Tile rectangle covered by a sphere, from the screen bounds of its box.
+// Returns false when the sphere is outside the frustum; a box reaching
+// behind the eye covers the whole screen.
+bool lightTileRect(const LightUniform& light, const Matrix4f& viewProjection, const Frustum& frustum,
+                   int tilesX, int tilesY, int viewportWidth, int viewportHeight, int rect[4]) {
+    Vector3f center(light.position[0], light.position[1], light.position[2]);
+    float r = light.radius;
+    if (!sphereInFrustum(frustum, center, r)) {
+        return false;
+    }
+
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+    bool behind = false;
+    for (int corner = 0; corner < 8 && !behind; corner++) {
+        Vector4f p(center.x + ((corner & 1) ? r : -r),
+                   center.y + ((corner & 2) ? r : -r),
+                   center.z + ((corner & 4) ? r : -r), 1.0f);
+        Vector4f clip = viewProjection * p;
+        if (clip.w <= 1e-5f) {
+            behind = true;
+            break;
+        }
+        float x = clip.x / clip.w, y = clip.y / clip.w;
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+    }
+
+    if (behind) {
+        rect[0] = 0; rect[1] = 0; rect[2] = tilesX - 1; rect[3] = tilesY - 1;
+        return true;
+    }
+    if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) {
+        return false;
+    }
+
+    rect[0] = std::max(0, (int)((minX * 0.5f + 0.5f) * viewportWidth) / LIGHT_TILE_SIZE);
+    rect[1] = std::max(0, (int)((minY * 0.5f + 0.5f) * viewportHeight) / LIGHT_TILE_SIZE);
+    rect[2] = std::min(tilesX - 1, (int)((maxX * 0.5f + 0.5f) * viewportWidth) / LIGHT_TILE_SIZE);
+    rect[3] = std::min(tilesY - 1, (int)((maxY * 0.5f + 0.5f) * viewportHeight) / LIGHT_TILE_SIZE);
+    return true;
+}
+
+// Builds the per-tile light lists for the lights in data, which must be the
+// packed list the LightData block holds, seen through viewProjection.
+void assignLightTiles(LightTiles& tiles, const LightUniforms& data, const Matrix4f& viewProjection,
+                      int viewportWidth, int viewportHeight) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    tiles.tilesX = std::max(1, (viewportWidth + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE);
+    tiles.tilesY = std::max(1, (viewportHeight + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE);
+    int tileCount = tiles.tilesX * tiles.tilesY;
+
+    Frustum frustum;
+    extractFrustum(viewProjection, frustum);
+
+    // First pass counts the lights per tile, the second fills the index
+    // list at the offsets the counts give.
+    tiles.tiles.assign(tileCount * 2, 0);
+    tiles.rects.resize(data.lightCount * 4);
+    for (int i = 0; i < data.lightCount; i++) {
+        int* rect = &tiles.rects[i * 4];
+        const LightUniform& light = data.lights[i];
+        if (light.radius <= 0.0f) {
+            rect[0] = 0; rect[1] = 0; rect[2] = tiles.tilesX - 1; rect[3] = tiles.tilesY - 1;
+        } else if (!lightTileRect(light, viewProjection, frustum, tiles.tilesX, tiles.tilesY,
+                                  viewportWidth, viewportHeight, rect)) {
+            rect[0] = -1;
+            continue;
+        }
+        for (int y = rect[1]; y <= rect[3]; y++) {
+            for (int x = rect[0]; x <= rect[2]; x++) {
+                tiles.tiles[(y * tiles.tilesX + x) * 2 + 1]++;
+            }
+        }
+    }
+
+    GLuint total = 0;
+    for (int t = 0; t < tileCount; t++) {
+        tiles.tiles[t * 2] = total;
+        total += tiles.tiles[t * 2 + 1];
+        tiles.tiles[t * 2 + 1] = 0;
+    }
+
+    tiles.indices.resize(std::max<GLuint>(total, 1));
+    for (int i = 0; i < data.lightCount; i++) {
+        const int* rect = &tiles.rects[i * 4];
+        if (rect[0] < 0) {
+            continue;
+        }
+        for (int y = rect[1]; y <= rect[3]; y++) {
+            for (int x = rect[0]; x <= rect[2]; x++) {
+                GLuint* tile = &tiles.tiles[(y * tiles.tilesX + x) * 2];
+                tiles.indices[tile[0] + tile[1]++] = i;
+            }
+        }
+    }
+
+    tiles.averageLightsPerTile = (float)total / tileCount;
+    auto end = std::chrono::high_resolution_clock::now();
+    tiles.lastAssignMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void uploadTileBuffer(GLuint& buffer, GLuint& texture, size_t& capacity, GLenum format, const std::vector<GLuint>& data) {
+    if (texture == 0) {
+        glGenBuffers(1, &buffer);
+        glGenTextures(1, &texture);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (data.size() > capacity) {
+        capacity = data.size() * 2;
+        glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(GLuint), NULL, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, data.size() * sizeof(GLuint), data.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void uploadLightTiles(LightTiles& tiles) {
+    uploadTileBuffer(tiles.tileBuffer, tiles.tileTexture, tiles.tileCapacity, GL_RG32UI, tiles.tiles);
+    uploadTileBuffer(tiles.indexBuffer, tiles.indexTexture, tiles.indexCapacity, GL_R32UI, tiles.indices);
+}
+
+void destroyLightTiles(LightTiles& tiles) {
+    if (tiles.tileTexture != 0) {
+        glDeleteTextures(1, &tiles.tileTexture);
+        glDeleteBuffers(1, &tiles.tileBuffer);
+    }
+    if (tiles.indexTexture != 0) {
+        glDeleteTextures(1, &tiles.indexTexture);
+        glDeleteBuffers(1, &tiles.indexBuffer);
+    }
+    tiles = LightTiles();
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+// Leveled logging, event counters and one summary line per pipeline stage
+// (shared by Q1 and Q1_cpu). Messages above LOG_LEVEL are compiled out,
+// arguments included, and -DLOG_LEVEL=0 removes counters and summaries as
+// well. g_log.level lowers the level at runtime.
+//
+// Hot paths count instead of printing. LOG_WARN_EVERY adds to a counter and
+// only prints when the total passes 1, 10, 100, ..., so a mesh with a million
+// bad triangles costs seven lines rather than a million.
+//
+// Counters and summaries may be updated from any thread.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+enum LogCounter {
+    LOG_DEGENERATE_TRIANGLES,
+    LOG_NON_TRIANGLES,
+    LOG_SLICES,
+    LOG_SEGMENTS,
+    LOG_UPLOADS,
+    LOG_UPLOADED_VERTICES,
+    LOG_EXPLOSION_UPDATES,
+    LOG_PLANE_UPDATES,
+    LOG_LIGHTS_LEFT_OUT,
+    LOG_COUNTER_COUNT
+};
+
+const char* LOG_COUNTER_NAMES[LOG_COUNTER_COUNT] = {
+    "Degenerate triangles skipped",
+    "Non-triangles skipped",
+    "Slices",
+    "Segments created",
+    "Uploads",
+    "Vertices uploaded",
+    "Explosion updates",
+    "Plane updates",
+    "Lights left out"
+};
+
+enum LogStage {
+    LOG_STAGE_SLICE,
+    LOG_STAGE_UPLOAD,
+    LOG_STAGE_EXPLOSION,
+    LOG_STAGE_PLANES,
+    LOG_STAGE_COUNT
+};
+
+const char* LOG_STAGE_NAMES[LOG_STAGE_COUNT] = {"Slice", "Upload", "Explosion", "Planes"};
+const char* LOG_LEVEL_NAMES[] = {"None", "Error", "Warning", "Info", "Debug"};
+
+const size_t LOG_SUMMARY_LENGTH = 160;
+
+struct LogState {
+    std::atomic<int> level;
+    std::atomic<uint64_t> counters[LOG_COUNTER_COUNT];
+    std::mutex mutex;  // guards summaries
+    char summaries[LOG_STAGE_COUNT][LOG_SUMMARY_LENGTH];
+
+    LogState() : level(LOG_LEVEL) {
+        for (int i = 0; i < LOG_COUNTER_COUNT; i++) {
+            counters[i] = 0;
+        }
+        for (int i = 0; i < LOG_STAGE_COUNT; i++) {
+            summaries[i][0] = '\0';
+        }
+    }
+};
+
+extern LogState g_log;
+
+void logMessageV(int level, const char* format, va_list args) {
+    if (level > g_log.level.load(std::memory_order_relaxed)) {
+        return;
+    }
+    vfprintf(level == LOG_LEVEL_ERROR ? stderr : stdout, format, args);
+}
+
+void logMessage(int level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logMessageV(level, format, args);
+    va_end(args);
+}
+
+uint64_t logCount(LogCounter counter) {
+    return g_log.counters[counter].load(std::memory_order_relaxed);
+}
+
+void resetLogCounters() {
+    for (int i = 0; i < LOG_COUNTER_COUNT; i++) {
+        g_log.counters[i] = 0;
+    }
+}
+
+// Adds n to the counter and warns if the total passed a power of ten.
+void logWarnEvery(LogCounter counter, uint64_t n, const char* format, ...) {
+    if (n == 0) {
+        return;
+    }
+    uint64_t before = g_log.counters[counter].fetch_add(n, std::memory_order_relaxed);
+    uint64_t after = before + n;
+    uint64_t decade = 1;
+    while (decade <= before) {
+        decade *= 10;
+    }
+    if (decade > after) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    logMessageV(LOG_LEVEL_WARN, format, args);
+    va_end(args);
+    logMessage(LOG_LEVEL_WARN, " (%llu so far)\n", (unsigned long long)after);
+}
+
+// Replaces the stage's summary line and prints it at info level.
+void logSummary(LogStage stage, const char* format, ...) {
+    char line[LOG_SUMMARY_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    {
+        std::lock_guard<std::mutex> lock(g_log.mutex);
+        snprintf(g_log.summaries[stage], LOG_SUMMARY_LENGTH, "%s", line);
+    }
+    logMessage(LOG_LEVEL_INFO, "%s: %s\n", LOG_STAGE_NAMES[stage], line);
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logMessage(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logMessage(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logMessage(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logMessage(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+#define LOG_COUNT(counter, n) g_log.counters[counter].fetch_add(n, std::memory_order_relaxed)
+#define LOG_SUMMARY(stage, ...) logSummary(stage, __VA_ARGS__)
+#else
+#define LOG_COUNT(counter, n) ((void)0)
+#define LOG_SUMMARY(stage, ...) ((void)0)
+#endif
+
+// The message is only printed (without a newline; the total is appended)
+// when warnings are compiled in, but the counter always advances.
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN_EVERY(counter, n, ...) logWarnEvery(counter, n, __VA_ARGS__)
+#else
+#define LOG_WARN_EVERY(counter, n, ...) LOG_COUNT(counter, n)
+#endif
+
+#endif
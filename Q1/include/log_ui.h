@@ -0,0 +1,30 @@
+#ifndef LOG_UI_H
+#define LOG_UI_H
+
+#include "imgui.h"
+#include "log.h"
+
+// Runtime level, counters and the last summary of every stage. Draws into
+// the current window.
+void drawLogPanel(LogState& log) {
+    int level = log.level.load();
+    if (ImGui::SliderInt("Log level", &level, LOG_LEVEL_NONE, LOG_LEVEL, LOG_LEVEL_NAMES[level])) {
+        log.level = level;
+    }
+
+    for (int i = 0; i < LOG_COUNTER_COUNT; i++) {
+        ImGui::Text("%s: %llu", LOG_COUNTER_NAMES[i], (unsigned long long)log.counters[i].load());
+    }
+    if (ImGui::Button("Reset counters")) {
+        resetLogCounters();
+    }
+
+    std::lock_guard<std::mutex> lock(log.mutex);
+    for (int i = 0; i < LOG_STAGE_COUNT; i++) {
+        if (log.summaries[i][0] != '\0') {
+            ImGui::TextWrapped("%s: %s", LOG_STAGE_NAMES[i], log.summaries[i]);
+        }
+    }
+}
+
+#endif
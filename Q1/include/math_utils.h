@@ -22,6 +22,20 @@
 #include <stdio.h>
 #include <iostream>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+// The 4x4 products and the batch transforms below have SSE versions. Every
+// x86-64 compiler enables SSE by default; other targets, or a build with
+// -DMATH_NO_SIMD, use the scalar versions, which are always compiled so that
+// math_bench can check one against the other.
+#if defined(__SSE__) && !defined(MATH_NO_SIMD)
+#define MATH_SIMD 1
+#include <xmmintrin.h>
+#else
+#define MATH_SIMD 0
+#endif
 
 #define ToRadian(x) (float)(((x) * M_PI / 180.0f))
 #define ToDegree(x) (float)(((x) * 180.0f / M_PI))
@@ -110,11 +124,11 @@ struct Vector3f {
 	}
 
 	Vector3f & Normalize() {
-		const float Length = sqrtf(x * x + y * y + z * z);
+		const float InvLength = 1.0f / sqrtf(x * x + y * y + z * z);
 
-		x /= Length;
-		y /= Length;
-		z /= Length;
+		x *= InvLength;
+		y *= InvLength;
+		z *= InvLength;
 
 		return *this;
 	}
@@ -226,7 +240,7 @@ struct PersProjInfo {
 
 class Matrix4f {
 public:
-	float m[4][4];
+	alignas(16) float m[4][4];
 
 	Matrix4f() {
 	}
@@ -288,7 +302,7 @@ public:
 		m[3][3] = 1.0f;
 	}
 
-	inline Matrix4f operator*(const Matrix4f& Right) const {
+	Matrix4f MultiplyScalar(const Matrix4f& Right) const {
 		Matrix4f Ret;
 
 		for (unsigned int i = 0; i < 4; i++) {
@@ -303,6 +317,33 @@ public:
 		return Ret;
 	}
 
+	// Row i of the product is the rows of Right weighted by row i of this
+	// matrix, so each output row is four broadcasts and multiply-adds.
+	inline Matrix4f operator*(const Matrix4f& Right) const {
+#if MATH_SIMD
+		Matrix4f Ret;
+		const __m128 r0 = _mm_load_ps(Right.m[0]);
+		const __m128 r1 = _mm_load_ps(Right.m[1]);
+		const __m128 r2 = _mm_load_ps(Right.m[2]);
+		const __m128 r3 = _mm_load_ps(Right.m[3]);
+
+		for (unsigned int i = 0; i < 4; i++) {
+			const __m128 l = _mm_load_ps(m[i]);
+			__m128 row = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3));
+			_mm_store_ps(Ret.m[i], row);
+		}
+
+		return Ret;
+#else
+		return MultiplyScalar(Right);
+#endif
+	}
+
+	// A single product stays scalar: the compiler vectorizes it as well as
+	// the row-dot-product SSE version would, without the transpose.
 	Vector4f operator*(const Vector4f& v) const {
 		Vector4f r;
 
@@ -547,4 +588,126 @@ public:
 	}
 };
 
+// Transforms count points by m, as (x, y, z, w) with w set to w, keeping the
+// xyz of the result without a perspective divide. w = 1 transforms positions
+// and w = 0 directions (normals only under rotations and uniform scales).
+// in and out may be the same array.
+void transformPointsScalar(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t count, float w = 1.0f) {
+	for (size_t i = 0; i < count; i++) {
+		const Vector3f p = in[i];
+		out[i].x = m.m[0][0] * p.x + m.m[0][1] * p.y + m.m[0][2] * p.z + m.m[0][3] * w;
+		out[i].y = m.m[1][0] * p.x + m.m[1][1] * p.y + m.m[1][2] * p.z + m.m[1][3] * w;
+		out[i].z = m.m[2][0] * p.x + m.m[2][1] * p.y + m.m[2][2] * p.z + m.m[2][3] * w;
+	}
+}
+
+void transformPoints(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t count, float w = 1.0f) {
+	size_t i = 0;
+#if MATH_SIMD
+	// Four points at a time, straight from the 12 packed floats
+	// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3. Output lane k of each register
+	// is one row of m applied to one point, so the matrix columns are
+	// pre-rotated to the row order of that register and each input component
+	// is spread to the lanes of its point; no transposes either way.
+	const __m128 x0 = _mm_setr_ps(m.m[0][0], m.m[1][0], m.m[2][0], m.m[0][0]);
+	const __m128 y0 = _mm_setr_ps(m.m[0][1], m.m[1][1], m.m[2][1], m.m[0][1]);
+	const __m128 z0 = _mm_setr_ps(m.m[0][2], m.m[1][2], m.m[2][2], m.m[0][2]);
+	const __m128 x1 = _mm_setr_ps(m.m[1][0], m.m[2][0], m.m[0][0], m.m[1][0]);
+	const __m128 y1 = _mm_setr_ps(m.m[1][1], m.m[2][1], m.m[0][1], m.m[1][1]);
+	const __m128 z1 = _mm_setr_ps(m.m[1][2], m.m[2][2], m.m[0][2], m.m[1][2]);
+	const __m128 x2 = _mm_setr_ps(m.m[2][0], m.m[0][0], m.m[1][0], m.m[2][0]);
+	const __m128 y2 = _mm_setr_ps(m.m[2][1], m.m[0][1], m.m[1][1], m.m[2][1]);
+	const __m128 z2 = _mm_setr_ps(m.m[2][2], m.m[0][2], m.m[1][2], m.m[2][2]);
+	const __m128 t0 = _mm_mul_ps(_mm_setr_ps(m.m[0][3], m.m[1][3], m.m[2][3], m.m[0][3]), _mm_set1_ps(w));
+	const __m128 t1 = _mm_mul_ps(_mm_setr_ps(m.m[1][3], m.m[2][3], m.m[0][3], m.m[1][3]), _mm_set1_ps(w));
+	const __m128 t2 = _mm_mul_ps(_mm_setr_ps(m.m[2][3], m.m[0][3], m.m[1][3], m.m[2][3]), _mm_set1_ps(w));
+
+	for (; i + 4 <= count; i += 4) {
+		const float* src = &in[i].x;
+		const __m128 a0 = _mm_loadu_ps(src);
+		const __m128 a1 = _mm_loadu_ps(src + 4);
+		const __m128 a2 = _mm_loadu_ps(src + 8);
+
+		// Lanes hold points 0 0 0 1
+		const __m128 y01 = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(0, 0, 1, 1));
+		const __m128 z01 = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 r0 = _mm_add_ps(_mm_mul_ps(x0, _mm_shuffle_ps(a0, a0, _MM_SHUFFLE(3, 0, 0, 0))), t0);
+		r0 = _mm_add_ps(r0, _mm_mul_ps(y0, _mm_shuffle_ps(y01, y01, _MM_SHUFFLE(2, 0, 0, 0))));
+		r0 = _mm_add_ps(r0, _mm_mul_ps(z0, _mm_shuffle_ps(z01, z01, _MM_SHUFFLE(2, 0, 0, 0))));
+
+		// Points 1 1 2 2
+		__m128 r1 = _mm_add_ps(_mm_mul_ps(x1, _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 2, 3, 3))), t1);
+		r1 = _mm_add_ps(r1, _mm_mul_ps(y1, _mm_shuffle_ps(a1, a1, _MM_SHUFFLE(3, 3, 0, 0))));
+		r1 = _mm_add_ps(r1, _mm_mul_ps(z1, _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(0, 0, 1, 1))));
+
+		// Points 2 3 3 3
+		const __m128 x23 = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 y23 = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2, 2, 3, 3));
+		__m128 r2 = _mm_add_ps(_mm_mul_ps(x2, _mm_shuffle_ps(x23, x23, _MM_SHUFFLE(2, 2, 2, 0))), t2);
+		r2 = _mm_add_ps(r2, _mm_mul_ps(y2, _mm_shuffle_ps(y23, y23, _MM_SHUFFLE(2, 2, 2, 0))));
+		r2 = _mm_add_ps(r2, _mm_mul_ps(z2, _mm_shuffle_ps(a2, a2, _MM_SHUFFLE(3, 3, 3, 0))));
+
+		float* dst = &out[i].x;
+		_mm_storeu_ps(dst, r0);
+		_mm_storeu_ps(dst + 4, r1);
+		_mm_storeu_ps(dst + 8, r2);
+	}
+#endif
+	transformPointsScalar(m, in + i, out + i, count - i, w);
+}
+
+// Batch transform over structure-of-arrays input: x, y and z live in
+// separate arrays, so each SIMD load picks up four points with no shuffling.
+// Writes the xyz of m * (x, y, z, w), and the w row too when outW is given
+// (clip-space w, or a fourth plane when m's rows are planes). Outputs may
+// alias the inputs.
+struct TransformSoA {
+	const float* x;
+	const float* y;
+	const float* z;
+	float* outX;
+	float* outY;
+	float* outZ;
+	float* outW;  // may be null
+};
+
+void transformPointsSoAScalar(const Matrix4f& m, const TransformSoA& soa, size_t begin, size_t end, float w = 1.0f) {
+	for (size_t i = begin; i < end; i++) {
+		const float x = soa.x[i], y = soa.y[i], z = soa.z[i];
+		soa.outX[i] = m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z + m.m[0][3] * w;
+		soa.outY[i] = m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z + m.m[1][3] * w;
+		soa.outZ[i] = m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z + m.m[2][3] * w;
+		if (soa.outW) {
+			soa.outW[i] = m.m[3][0] * x + m.m[3][1] * y + m.m[3][2] * z + m.m[3][3] * w;
+		}
+	}
+}
+
+void transformPointsSoA(const Matrix4f& m, const TransformSoA& soa, size_t begin, size_t end, float w = 1.0f) {
+	size_t i = begin;
+#if MATH_SIMD
+	__m128 c[4][4];
+	for (int row = 0; row < 4; row++) {
+		c[row][0] = _mm_set1_ps(m.m[row][0]);
+		c[row][1] = _mm_set1_ps(m.m[row][1]);
+		c[row][2] = _mm_set1_ps(m.m[row][2]);
+		c[row][3] = _mm_set1_ps(m.m[row][3] * w);
+	}
+	const int rows = soa.outW ? 4 : 3;
+	float* out[4] = {soa.outX, soa.outY, soa.outZ, soa.outW};
+
+	for (; i + 4 <= end; i += 4) {
+		const __m128 x = _mm_loadu_ps(soa.x + i);
+		const __m128 y = _mm_loadu_ps(soa.y + i);
+		const __m128 z = _mm_loadu_ps(soa.z + i);
+		for (int row = 0; row < rows; row++) {
+			__m128 r = _mm_add_ps(_mm_mul_ps(c[row][0], x), _mm_mul_ps(c[row][1], y));
+			r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(c[row][2], z), c[row][3]));
+			_mm_storeu_ps(out[row] + i, r);
+		}
+	}
+#endif
+	transformPointsSoAScalar(m, soa, i, end, w);
+}
+
 #endif
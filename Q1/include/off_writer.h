@@ -0,0 +1,130 @@
+#ifndef OFF_WRITER_H
+#define OFF_WRITER_H
+
+#include "math_utils.h"
+#include "OFFReader.h"
+#include "mesh_slicer.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+// Streams a file through one large buffer so that writing a segment costs a
+// handful of fwrite calls instead of one per vertex.
+struct BufferedWriter {
+    FILE* file = nullptr;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool ok = false;
+};
+
+const size_t WRITER_BUFFER_SIZE = 1 << 20;
+
+bool openWriter(BufferedWriter& writer, const char* path) {
+    writer.file = fopen(path, "wb");
+    writer.buffer.resize(WRITER_BUFFER_SIZE);
+    writer.used = 0;
+    writer.ok = writer.file != nullptr;
+    if (!writer.ok) {
+        fprintf(stderr, "Error: Could not open %s for writing\n", path);
+    }
+    return writer.ok;
+}
+
+void flushWriter(BufferedWriter& writer) {
+    if (writer.used > 0 && writer.ok) {
+        writer.ok = fwrite(writer.buffer.data(), 1, writer.used, writer.file) == writer.used;
+    }
+    writer.used = 0;
+}
+
+void writeBytes(BufferedWriter& writer, const void* data, size_t size) {
+    if (writer.used + size > writer.buffer.size()) {
+        flushWriter(writer);
+        if (size > writer.buffer.size()) {
+            writer.ok = writer.ok && fwrite(data, 1, size, writer.file) == size;
+            return;
+        }
+    }
+    memcpy(writer.buffer.data() + writer.used, data, size);
+    writer.used += size;
+}
+
+void writeText(BufferedWriter& writer, const char* format, ...) {
+    // Every line written here is short; flushing first guarantees room for it.
+    if (writer.buffer.size() - writer.used < 256) {
+        flushWriter(writer);
+    }
+
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(writer.buffer.data() + writer.used, writer.buffer.size() - writer.used, format, args);
+    va_end(args);
+
+    if (n > 0) {
+        writer.used += std::min((size_t)n, writer.buffer.size() - writer.used - 1);
+    }
+}
+
+bool closeWriter(BufferedWriter& writer) {
+    flushWriter(writer);
+    if (writer.file) {
+        writer.ok = fclose(writer.file) == 0 && writer.ok;
+        writer.file = nullptr;
+    }
+    return writer.ok;
+}
+
+// Plain OFF, readable by readOffFile. The explosion offset is applied so the
+// file matches what the viewer shows.
+bool writeSegmentOff(const char* path, const MeshSlicerState& state, const MeshSegment& segment) {
+    BufferedWriter writer;
+    if (!openWriter(writer, path)) {
+        return false;
+    }
+
+    const SlicedVertex* vertices = segmentVertices(state, segment);
+    const unsigned int* indices = segmentIndices(state, segment);
+
+    writeText(writer, "OFF\n%zu %zu 0\n", segment.vertexCount, segment.indexCount / 3);
+    for (size_t i = 0; i < segment.vertexCount; i++) {
+        Vector3f p = vertices[i].position + segment.offset;
+        writeText(writer, "%.9g %.9g %.9g\n", p.x, p.y, p.z);
+    }
+    for (size_t i = 0; i + 2 < segment.indexCount; i += 3) {
+        writeText(writer, "3 %u %u %u\n", indices[i], indices[i + 1], indices[i + 2]);
+    }
+
+    return closeWriter(writer);
+}
+
+// Binary layout: "SEG1", uint32 vertex count, uint32 index count, float[3]
+// colour, then per vertex float[3] position and float[3] normal, then the
+// uint32 indices. All little-endian as written by the host.
+bool writeSegmentBinary(const char* path, const MeshSlicerState& state, const MeshSegment& segment) {
+    BufferedWriter writer;
+    if (!openWriter(writer, path)) {
+        return false;
+    }
+
+    const SlicedVertex* vertices = segmentVertices(state, segment);
+    uint32_t vertexCount = segment.vertexCount;
+    uint32_t indexCount = segment.indexCount;
+
+    writeBytes(writer, "SEG1", 4);
+    writeBytes(writer, &vertexCount, sizeof(vertexCount));
+    writeBytes(writer, &indexCount, sizeof(indexCount));
+    writeBytes(writer, &segment.segmentColor, sizeof(Vector3f));
+    for (size_t i = 0; i < segment.vertexCount; i++) {
+        Vector3f p = vertices[i].position + segment.offset;
+        writeBytes(writer, &p, sizeof(Vector3f));
+        writeBytes(writer, &vertices[i].normal, sizeof(Vector3f));
+    }
+    writeBytes(writer, segmentIndices(state, segment), indexCount * sizeof(unsigned int));
+
+    return closeWriter(writer);
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include "math_utils.h"
+#include "OFFReader.h"
+#include "mesh_slicer.h"
+#include "bvh.h"
+#include "explosion.h"
+#include <vector>
+#include <memory>
+#include <chrono>
+
+// Mouse picking against the whole model or the sliced segments. The model
+// gets one BVH, refit when the explosion moves its triangles; every segment
+// gets its own BVH in arena coordinates, and the pick ray is shifted by the
+// segment's offset instead. Trees are built on the first pick after a load or
+// slice, so nothing is spent on them until picking is used.
+
+struct PickState {
+    const OffModel* model = nullptr;  // model the model BVH was built for
+    BVH modelBVH;
+    float modelExplosion = 0.0f;      // explosion the model BVH was refit for
+    std::shared_ptr<const SegmentArena> arena;  // arena the segment BVHs were built for
+    std::vector<BVH> segmentBVHs;
+    int pickedSegment = -1;
+    int pickedTriangle = -1;
+    double lastPickMs = 0.0;   // traversal only
+    double lastBuildMs = 0.0;  // last lazy BVH build
+};
+
+// Ray through a point in normalized device coordinates, in the space that
+// clipFromObject maps to clip space (pass projection * view * world for
+// model space). The second point is taken at depth 0 rather than 1: the
+// projection in main.cpp has no far plane, and its depth 1 lies on the other
+// side of infinity, so the ray would point away from the scene.
+bool unprojectRay(const Matrix4f& clipFromObject, float ndcX, float ndcY, PickRay& ray) {
+    Matrix4f inverse = clipFromObject;
+    if (inverse.Determinant() == 0.0f) {
+        return false;
+    }
+    inverse.Inverse();
+
+    Vector4f nearPoint = inverse * Vector4f(ndcX, ndcY, -1.0f, 1.0f);
+    Vector4f farPoint = inverse * Vector4f(ndcX, ndcY, 0.0f, 1.0f);
+    if (nearPoint.w == 0.0f || farPoint.w == 0.0f) {
+        return false;
+    }
+    ray.origin = Vector3f(nearPoint.x, nearPoint.y, nearPoint.z) * (1.0f / nearPoint.w);
+    Vector3f farPosition = Vector3f(farPoint.x, farPoint.y, farPoint.z) * (1.0f / farPoint.w);
+    ray.direction = farPosition - ray.origin;
+    if (ray.direction.length() == 0.0f) {
+        return false;
+    }
+    ray.direction.Normalize();
+    return true;
+}
+
+bool rayMissesSphere(const PickRay& ray, const Vector3f& center, float radius, float maxT) {
+    Vector3f toCenter = center - ray.origin;
+    float along = toCenter.Dot(ray.direction);
+    float distanceSquared = toCenter.Dot(toCenter) - along * along;
+    return distanceSquared > radius * radius || along + radius < 0.0f || along - radius > maxT;
+}
+
+// Index of the model triangle under the ray, or -1.
+int pickModelTriangle(PickState& state, const OffModel* model, float explosionFactor, const PickRay& ray, BVHHit& hit) {
+    if (state.model != model) {
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<unsigned int> indices;
+        indices.reserve(model->numberOfPolygons * 3);
+        for (int i = 0; i < model->numberOfPolygons; i++) {
+            for (int j = 0; j < 3; j++) {
+                indices.push_back(model->polygons[i].v[j]);
+            }
+        }
+        buildBVH(state.modelBVH, &model->vertices[0].x, sizeof(Vertex), indices.data(), model->numberOfPolygons);
+        state.model = model;
+        state.modelExplosion = 0.0f;
+        state.lastBuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    if (state.modelExplosion != explosionFactor) {
+        std::vector<Vector3f> offsets;
+        computeExplosionOffsets(model, explosionFactor, offsets);
+        BVH& bvh = state.modelBVH;
+        for (size_t i = 0; i < bvh.ids.size(); i++) {
+            const Polygon& polygon = model->polygons[bvh.ids[i]];
+            for (int j = 0; j < 3; j++) {
+                const Vertex& v = model->vertices[polygon.v[j]];
+                bvh.vertices[i * 3 + j] = Vector3f(v.x, v.y, v.z) + offsets[bvh.ids[i]];
+            }
+        }
+        refitBVH(bvh);
+        state.modelExplosion = explosionFactor;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int picked = intersectBVH(state.modelBVH, ray, hit) ? (int)hit.triangle : -1;
+    state.lastPickMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return picked;
+}
+
+// Index of the nearest segment under the ray, or -1.
+int pickSegment(PickState& state, const MeshSlicerState& slicer, const PickRay& ray, BVHHit& hit) {
+    if (!slicer.arena) {
+        return -1;
+    }
+    if (state.arena != slicer.arena || state.segmentBVHs.size() != slicer.segments.size()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        const SegmentArena& arena = *slicer.arena;
+        state.segmentBVHs.resize(slicer.segments.size());
+        for (size_t i = 0; i < slicer.segments.size(); i++) {
+            const MeshSegment& segment = slicer.segments[i];
+            const void* positions = segment.vertexCount > 0 ? &arena.vertices[segment.firstVertex].position.x : nullptr;
+            buildBVH(state.segmentBVHs[i], positions, sizeof(SlicedVertex),
+                     segment.indexCount > 0 ? &arena.indices[segment.firstIndex] : nullptr, segment.indexCount / 3);
+        }
+        state.arena = slicer.arena;
+        state.lastBuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int picked = -1;
+    for (size_t i = 0; i < slicer.segments.size(); i++) {
+        const MeshSegment& segment = slicer.segments[i];
+        if (rayMissesSphere(ray, segment.boundsCenter + segment.offset, segment.boundsRadius, hit.t)) {
+            continue;
+        }
+        PickRay local = ray;
+        local.origin -= segment.offset;
+        if (intersectBVH(state.segmentBVHs[i], local, hit)) {
+            picked = i;
+        }
+    }
+    state.lastPickMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return picked;
+}
+
+#endif
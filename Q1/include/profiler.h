@@ -0,0 +1,204 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <sys/resource.h>
+
+// Frame-time profiler. Named scopes keep a rolling history of their last
+// PROFILER_HISTORY samples for the overlay's percentiles, and every sample
+// also goes into a ring of trace events that saveChromeTrace writes out as
+// Chrome trace JSON (load it in chrome://tracing or ui.perfetto.dev).
+//
+// Scope names must be string literals; they are stored by pointer. Scopes
+// may be recorded from any thread.
+
+const int PROFILER_HISTORY = 240;
+const size_t PROFILER_TRACE_EVENTS = 1 << 16;
+
+struct ProfileSeries {
+    const char* name;
+    float history[PROFILER_HISTORY];  // milliseconds, ring buffer
+    int head = 0;
+    int count = 0;
+    float last = 0.0f;
+};
+
+struct TraceEvent {
+    const char* name;
+    double startUs;
+    double durationUs;
+    int threadId;
+};
+
+struct ProfileStats {
+    float last, p50, p95, p99, max;
+    int count;
+};
+
+struct Profiler {
+    std::chrono::high_resolution_clock::time_point origin = std::chrono::high_resolution_clock::now();
+    std::mutex mutex;
+    std::vector<ProfileSeries> series;
+    std::vector<TraceEvent> trace;  // ring of the last PROFILER_TRACE_EVENTS events
+    size_t traceHead = 0;
+};
+
+extern Profiler g_profiler;
+
+double profilerNowUs(const Profiler& profiler) {
+    return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - profiler.origin).count();
+}
+
+// Small stable id per thread for the trace viewer; the first thread to record
+// (the render thread) gets 1.
+int profilerThreadId() {
+    static std::atomic<int> nextId(1);
+    static thread_local int id = 0;
+    if (id == 0) {
+        id = nextId++;
+    }
+    return id;
+}
+
+ProfileSeries& profileSeries(Profiler& profiler, const char* name) {
+    for (ProfileSeries& s : profiler.series) {
+        if (s.name == name || strcmp(s.name, name) == 0) {
+            return s;
+        }
+    }
+    ProfileSeries s;
+    s.name = name;
+    profiler.series.push_back(s);
+    return profiler.series.back();
+}
+
+// Records one sample. startUs is only used for the trace and may be negative
+// for samples that have no CPU-side start (GPU timings).
+void profileRecord(Profiler& profiler, const char* name, double startUs, double durationUs) {
+    int threadId = profilerThreadId();
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+
+    ProfileSeries& s = profileSeries(profiler, name);
+    s.last = (float)(durationUs / 1000.0);
+    s.history[s.head] = s.last;
+    s.head = (s.head + 1) % PROFILER_HISTORY;
+    s.count = std::min(s.count + 1, PROFILER_HISTORY);
+
+    if (startUs < 0.0) {
+        return;
+    }
+    TraceEvent event = {name, startUs, durationUs, threadId};
+    if (profiler.trace.size() < PROFILER_TRACE_EVENTS) {
+        profiler.trace.push_back(event);
+    } else {
+        profiler.trace[profiler.traceHead] = event;
+    }
+    profiler.traceHead = (profiler.traceHead + 1) % PROFILER_TRACE_EVENTS;
+}
+
+struct ProfileScope {
+    Profiler& profiler;
+    const char* name;
+    double startUs;
+
+    ProfileScope(Profiler& p, const char* n) : profiler(p), name(n), startUs(profilerNowUs(p)) {}
+    ~ProfileScope() {
+        profileRecord(profiler, name, startUs, profilerNowUs(profiler) - startUs);
+    }
+};
+
+// User plus system CPU time of the whole process, all threads.
+double processCpuSeconds() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(g_profiler, name)
+
+float historyPercentile(std::vector<float>& sorted, float p) {
+    if (sorted.empty()) {
+        return 0.0f;
+    }
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool profileStats(Profiler& profiler, const char* name, ProfileStats& stats) {
+    std::vector<float> sorted;
+    {
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+        ProfileSeries* found = nullptr;
+        for (ProfileSeries& s : profiler.series) {
+            if (strcmp(s.name, name) == 0) {
+                found = &s;
+            }
+        }
+        if (!found || found->count == 0) {
+            return false;
+        }
+        sorted.assign(found->history, found->history + found->count);
+        stats.last = found->last;
+        stats.count = found->count;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+    stats.p50 = historyPercentile(sorted, 0.50f);
+    stats.p95 = historyPercentile(sorted, 0.95f);
+    stats.p99 = historyPercentile(sorted, 0.99f);
+    stats.max = sorted.back();
+    return true;
+}
+
+// Copies a series' history oldest first, for plotting.
+int profileHistory(Profiler& profiler, const char* name, float* out) {
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+    for (ProfileSeries& s : profiler.series) {
+        if (strcmp(s.name, name) == 0) {
+            int first = (s.head - s.count + PROFILER_HISTORY) % PROFILER_HISTORY;
+            for (int i = 0; i < s.count; i++) {
+                out[i] = s.history[(first + i) % PROFILER_HISTORY];
+            }
+            return s.count;
+        }
+    }
+    return 0;
+}
+
+bool saveChromeTrace(Profiler& profiler, const char* path) {
+    FILE* output = fopen(path, "w");
+    if (!output) {
+        fprintf(stderr, "Error: Could not write trace %s\n", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+    size_t count = profiler.trace.size();
+    size_t first = count < PROFILER_TRACE_EVENTS ? 0 : profiler.traceHead;
+
+    fprintf(output, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < count; i++) {
+        const TraceEvent& e = profiler.trace[(first + i) % count];
+        fprintf(output, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                e.name, e.threadId, e.startUs, e.durationUs, i + 1 < count ? "," : "");
+    }
+    fprintf(output, "]}\n");
+
+    bool ok = !ferror(output);
+    fclose(output);
+    printf("Wrote %zu trace events to %s\n", count, path);
+    return ok;
+}
+
+#endif
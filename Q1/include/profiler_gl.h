@@ -0,0 +1,147 @@
+#ifndef PROFILER_GL_H
+#define PROFILER_GL_H
+
+#include <GL/glew.h>
+#include "imgui.h"
+#include "profiler.h"
+#include "task_system.h"
+
+// GPU timings through GL_TIME_ELAPSED queries (core in 3.3, ARB_timer_query
+// on the 3.2 context we ask for). Each timer owns a small ring of queries and
+// only reads back ones the driver reports as available, so results lag a few
+// frames but never stall the pipeline. Without timer queries the timers do
+// nothing. TIME_ELAPSED queries cannot nest: keep GPU scopes disjoint.
+
+const int GPU_TIMER_QUERIES = 4;
+
+struct GpuTimer {
+    const char* name;
+    GLuint queries[GPU_TIMER_QUERIES];
+    bool pending[GPU_TIMER_QUERIES];
+    int next = 0;
+    bool supported = false;
+};
+
+void createGpuTimer(GpuTimer& timer, const char* name) {
+    timer.name = name;
+    timer.next = 0;
+    timer.supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    for (int i = 0; i < GPU_TIMER_QUERIES; i++) {
+        timer.queries[i] = 0;
+        timer.pending[i] = false;
+    }
+    if (timer.supported) {
+        glGenQueries(GPU_TIMER_QUERIES, timer.queries);
+    }
+}
+
+void destroyGpuTimer(GpuTimer& timer) {
+    if (timer.supported) {
+        glDeleteQueries(GPU_TIMER_QUERIES, timer.queries);
+    }
+    timer.supported = false;
+}
+
+// Collects every finished query into the profiler.
+void collectGpuTimer(GpuTimer& timer) {
+    if (!timer.supported) {
+        return;
+    }
+    for (int i = 0; i < GPU_TIMER_QUERIES; i++) {
+        int slot = (timer.next + i) % GPU_TIMER_QUERIES;
+        if (!timer.pending[slot]) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(timer.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(timer.queries[slot], GL_QUERY_RESULT, &elapsedNs);
+        timer.pending[slot] = false;
+        profileRecord(g_profiler, timer.name, -1.0, elapsedNs / 1000.0);
+    }
+}
+
+// Returns false (and times nothing) when every query is still in flight.
+bool beginGpuTimer(GpuTimer& timer) {
+    collectGpuTimer(timer);
+    if (!timer.supported || timer.pending[timer.next]) {
+        return false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, timer.queries[timer.next]);
+    return true;
+}
+
+void endGpuTimer(GpuTimer& timer) {
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.pending[timer.next] = true;
+    timer.next = (timer.next + 1) % GPU_TIMER_QUERIES;
+}
+
+// Overlay with one row per series and a plot of the frame time. Rows are
+// listed in the order the series were first recorded, followed by how busy
+// the task pool has been.
+void drawProfilerOverlay(Profiler& profiler, TaskSystem& tasks, const char* frameSeries, bool* open) {
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    if (!ImGui::Begin("Profiler", open, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings)) {
+        ImGui::End();
+        return;
+    }
+
+    float history[PROFILER_HISTORY];
+    int count = profileHistory(profiler, frameSeries, history);
+    ProfileStats frame;
+    if (count > 0 && profileStats(profiler, frameSeries, frame)) {
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.2f ms (%.0f FPS)", frame.p50, frame.p50 > 0.0f ? 1000.0f / frame.p50 : 0.0f);
+        ImGui::PlotLines("##frame", history, count, 0, overlay, 0.0f, std::max(frame.max, 16.7f), ImVec2(320, 60));
+    }
+
+    std::vector<const char*> names;
+    size_t traceEvents;
+    {
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+        for (const ProfileSeries& s : profiler.series) {
+            names.push_back(s.name);
+        }
+        traceEvents = profiler.trace.size();
+    }
+
+    if (ImGui::BeginTable("series", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("last");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableHeadersRow();
+        for (const char* name : names) {
+            ProfileStats stats;
+            if (!profileStats(profiler, name, stats)) {
+                continue;
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(name);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.last);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.p50);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.p95);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.p99);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Text("Task pool: %u workers, %.0f%% busy", tasks.workerCount, sampleTaskUtilization(tasks) * 100.0f);
+    ImGui::TextDisabled("%llu tasks, %llu stolen", (unsigned long long)tasks.tasksRun.load(),
+                        (unsigned long long)tasks.steals.load());
+
+    if (ImGui::Button("Save trace")) {
+        saveChromeTrace(profiler, "profile_trace.json");
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%zu events", traceEvents);
+
+    ImGui::End();
+}
+
+#endif
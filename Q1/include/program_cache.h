@@ -0,0 +1,113 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// On-disk cache of the linked shader program (glGetProgramBinary). The file
+// holds one program, tagged with a key over the driver strings and the shader
+// sources, so a driver update or an edited shader misses and the program is
+// compiled and saved again. Needs GL 4.1 or ARB_get_program_binary and a
+// driver that offers at least one binary format; otherwise nothing is cached.
+
+const char* PROGRAM_CACHE_PATH = "shader_program.cache";
+const uint32_t PROGRAM_CACHE_MAGIC = 0x31425051;  // "QPB1"
+
+struct ProgramCacheHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+bool programBinarySupported() {
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+void programHash(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+// FNV-1a over vendor, renderer and version, then every source in order.
+uint64_t programCacheKey(const std::vector<std::string>& sources) {
+    uint64_t hash = 14695981039346656037ull;
+    GLenum strings[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : strings) {
+        const char* value = (const char*)glGetString(name);
+        if (value) {
+            programHash(hash, value, strlen(value) + 1);
+        }
+    }
+    for (const std::string& source : sources) {
+        programHash(hash, source.data(), source.size() + 1);
+    }
+    return hash;
+}
+
+// Loads the cached binary into program if the key matches and the driver
+// accepts it. On false the program is untouched and can be compiled as usual.
+bool loadProgramBinary(GLuint program, const char* path, uint64_t key) {
+    FILE* input = fopen(path, "rb");
+    if (!input) {
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    bool ok = fread(&header, sizeof(header), 1, input) == 1 &&
+              header.magic == PROGRAM_CACHE_MAGIC && header.key == key && header.length > 0;
+    if (ok) {
+        binary.resize(header.length);
+        ok = fread(binary.data(), 1, binary.size(), input) == binary.size();
+    }
+    fclose(input);
+    if (!ok) {
+        return false;
+    }
+
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked != 0;
+}
+
+// Call after a successful link of a program created with
+// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+bool saveProgramBinary(GLuint program, const char* path, uint64_t key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    FILE* output = fopen(path, "wb");
+    if (!output) {
+        fprintf(stderr, "Warning: Could not write shader cache %s\n", path);
+        return false;
+    }
+    ProgramCacheHeader header = {PROGRAM_CACHE_MAGIC, format, key, (uint32_t)length, 0};
+    bool ok = fwrite(&header, sizeof(header), 1, output) == 1 &&
+              fwrite(binary.data(), 1, length, output) == (size_t)length;
+    fclose(output);
+    return ok;
+}
+
+#endif
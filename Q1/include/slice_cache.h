@@ -0,0 +1,155 @@
+#ifndef SLICE_CACHE_H
+#define SLICE_CACHE_H
+
+#include "mesh_slicer.h"
+#include "plane.h"
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// In-memory LRU cache of slice results. Entries share their arena with the
+// MeshSlicerState they were produced for, so a hit costs a copy of the small
+// segment list and nothing else. Planes are normalized and quantized before
+// hashing so that slider jitter below PLANE_QUANTUM still hits.
+
+const float PLANE_QUANTUM = 1.0e-4f;
+const size_t DEFAULT_SLICE_CACHE_BUDGET = 256u << 20;
+
+struct SliceCacheEntry {
+    uint64_t key;
+    std::shared_ptr<const SegmentArena> arena;
+    std::vector<MeshSegment> segments;
+    std::vector<Vector3f> centroids;
+    Vector3f centroid;
+    size_t bytes;
+};
+
+struct SliceCache {
+    size_t budgetBytes = DEFAULT_SLICE_CACHE_BUDGET;
+    size_t usedBytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    std::list<SliceCacheEntry> entries;  // most recently used first
+    std::unordered_map<uint64_t, std::list<SliceCacheEntry>::iterator> index;
+};
+
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+// FNV-1a over the model's identity and the ordered plane set. Order is kept
+// because it decides the region codes and colours of the segments.
+uint64_t sliceCacheKey(const OffModel* model, const std::vector<Plane>& planes) {
+    uint64_t hash = 14695981039346656037ull;
+
+    hashBytes(hash, &model, sizeof(model));
+    hashBytes(hash, &model->numberOfVertices, sizeof(model->numberOfVertices));
+    hashBytes(hash, &model->numberOfPolygons, sizeof(model->numberOfPolygons));
+    float bounds[6] = {model->minX, model->minY, model->minZ, model->maxX, model->maxY, model->maxZ};
+    hashBytes(hash, bounds, sizeof(bounds));
+
+    for (const Plane& plane : planes) {
+        float magnitude = sqrtf(plane.a*plane.a + plane.b*plane.b + plane.c*plane.c);
+        if (magnitude <= 0.0001f) {
+            magnitude = 1.0f;
+        }
+        int32_t q[4] = {
+            (int32_t)lroundf(plane.a / magnitude / PLANE_QUANTUM),
+            (int32_t)lroundf(plane.b / magnitude / PLANE_QUANTUM),
+            (int32_t)lroundf(plane.c / magnitude / PLANE_QUANTUM),
+            (int32_t)lroundf(plane.d / magnitude / PLANE_QUANTUM)
+        };
+        hashBytes(hash, q, sizeof(q));
+    }
+
+    return hash;
+}
+
+size_t sliceResultBytes(const MeshSlicerState& state) {
+    size_t bytes = state.segments.size() * sizeof(MeshSegment) + state.centroids.size() * sizeof(Vector3f);
+    if (state.arena) {
+        bytes += state.arena->vertices.size() * sizeof(SlicedVertex);
+        bytes += state.arena->indices.size() * sizeof(unsigned int);
+    }
+    return bytes;
+}
+
+void evictSliceCache(SliceCache& cache) {
+    while (cache.usedBytes > cache.budgetBytes && !cache.entries.empty()) {
+        SliceCacheEntry& victim = cache.entries.back();
+        cache.usedBytes -= victim.bytes;
+        cache.index.erase(victim.key);
+        cache.entries.pop_back();
+    }
+}
+
+void setSliceCacheBudget(SliceCache& cache, size_t budgetBytes) {
+    cache.budgetBytes = budgetBytes;
+    evictSliceCache(cache);
+}
+
+void insertSliceCache(SliceCache& cache, uint64_t key, const MeshSlicerState& state) {
+    auto found = cache.index.find(key);
+    if (found != cache.index.end()) {
+        cache.usedBytes -= found->second->bytes;
+        cache.entries.erase(found->second);
+        cache.index.erase(found);
+    }
+
+    SliceCacheEntry entry;
+    entry.key = key;
+    entry.arena = state.arena;
+    entry.segments = state.segments;
+    entry.centroids = state.centroids;
+    entry.centroid = state.centroid;
+    entry.bytes = sliceResultBytes(state);
+
+    // A result bigger than the whole budget would only evict everything else.
+    if (entry.bytes > cache.budgetBytes) {
+        return;
+    }
+
+    for (MeshSegment& segment : entry.segments) {
+        segment.offset = Vector3f(0.0f, 0.0f, 0.0f);
+    }
+
+    cache.entries.push_front(entry);
+    cache.index[key] = cache.entries.begin();
+    cache.usedBytes += entry.bytes;
+    evictSliceCache(cache);
+}
+
+// On a hit the entry becomes most recently used and is installed into state.
+bool lookupSliceCache(SliceCache& cache, uint64_t key, MeshSlicerState& state) {
+    auto found = cache.index.find(key);
+    if (found == cache.index.end()) {
+        cache.misses++;
+        return false;
+    }
+
+    cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+    const SliceCacheEntry& entry = *found->second;
+
+    state.arena = entry.arena;
+    state.segments = entry.segments;
+    state.centroids = entry.centroids;
+    state.centroid = entry.centroid;
+    cache.hits++;
+    return true;
+}
+
+void clearSliceCache(SliceCache& cache) {
+    cache.entries.clear();
+    cache.index.clear();
+    cache.usedBytes = 0;
+}
+
+#endif
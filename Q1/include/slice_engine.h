@@ -0,0 +1,390 @@
+#ifndef SLICE_ENGINE_H
+#define SLICE_ENGINE_H
+
+#include "log.h"
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+
+// Plane splitting shared by Q1 and Q1_cpu. Each includes it after its own
+// math_utils.h, OFFReader.h and plane.h, which supply Vector3f, OffModel and
+// Plane.
+// The variants differ in three ways, each chosen at compile time by a policy
+// type, so every combination gets its own inner loop with the unused checks
+// compiled out:
+//
+//   Weld         WeldVertices merges vertices within VERTEX_WELD_EPSILON of
+//                each other inside a segment; NoWeld emits three fresh
+//                vertices per triangle.
+//   Degenerates  SkipDegenerates drops triangles with a near zero edge or
+//                area; KeepDegenerates emits everything.
+//   Snap         SnapToVertices returns an edge's endpoint when it lies within
+//                SNAP_EPSILON of the plane; NoSnap always interpolates.
+//
+// Q1 slices with <WeldVertices, KeepDegenerates, NoSnap>, Q1_cpu with
+// <NoWeld, SkipDegenerates, SnapToVertices>.
+//
+// A fourth parameter decides how the regions of one plane pass are split:
+// SerialRegions does them one after another, and Q1 passes a runner that
+// spreads them over its task pool. Either way the pieces are appended in
+// region order, so the output does not depend on the runner.
+
+const float VERTEX_WELD_EPSILON = 0.0001f;
+const float SNAP_EPSILON = 0.0001f;
+const float DEGENERATE_EPSILON = 0.00001f;
+const size_t MAX_REGION_PLANES = 32;
+
+struct SlicedVertex {
+    Vector3f position;
+    Vector3f normal;
+    float r, g, b;
+
+    bool operator==(const SlicedVertex& other) const {
+        return (fabs(position.x - other.position.x) < VERTEX_WELD_EPSILON &&
+                fabs(position.y - other.position.y) < VERTEX_WELD_EPSILON &&
+                fabs(position.z - other.position.z) < VERTEX_WELD_EPSILON);
+    }
+};
+
+struct SlicedVertexHash {
+    std::size_t operator()(const SlicedVertex& v) const {
+        return std::hash<float>()(v.position.x) ^
+               std::hash<float>()(v.position.y) ^
+               std::hash<float>()(v.position.z);
+    }
+};
+
+// Geometry of every segment produced by one slice, stored back to back.
+// Segments only hold ranges into it; indices are local to their segment.
+struct SegmentArena {
+    std::vector<SlicedVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// One piece of the sliced mesh: its ranges in the arena and the side of every
+// plane it lies on.
+struct SliceRegion {
+    size_t firstVertex = 0;
+    size_t vertexCount = 0;
+    size_t firstIndex = 0;
+    size_t indexCount = 0;
+    unsigned int regionCode = 0;    // bit i set: positive side of plane i
+    unsigned int regionLength = 0;  // number of planes the code covers
+};
+
+// Scratch storage for the segment currently being built. The vertex map is
+// only used when welding, so it never ends up in the arena. The degenerate
+// count survives clear() and is reported once per slice.
+struct SegmentBuilder {
+    std::vector<SlicedVertex> vertices;
+    std::vector<unsigned int> indices;
+    std::unordered_map<SlicedVertex, unsigned int, SlicedVertexHash> vertexMap;
+    size_t skippedDegenerates = 0;
+
+    void clear() {
+        vertices.clear();
+        indices.clear();
+        vertexMap.clear();
+    }
+};
+
+struct WeldVertices { static const bool enabled = true; };
+struct NoWeld { static const bool enabled = false; };
+struct SkipDegenerates { static const bool enabled = true; };
+struct KeepDegenerates { static const bool enabled = false; };
+struct SnapToVertices { static const bool enabled = true; };
+struct NoSnap { static const bool enabled = false; };
+
+// A region runner splits up to batchSize(regionCount) regions at once, each
+// into its own pair of builders, by calling fn(i) for every i below count.
+struct SerialRegions {
+    static size_t batchSize(size_t) { return 1; }
+
+    template <typename Fn>
+    static void forEach(size_t count, const Fn& fn) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+    }
+};
+
+template <typename Weld>
+unsigned int addVertex(SegmentBuilder& segment, const SlicedVertex& v) {
+    if (Weld::enabled) {
+        auto it = segment.vertexMap.find(v);
+        if (it != segment.vertexMap.end()) {
+            return it->second;
+        }
+    }
+
+    unsigned int idx = segment.vertices.size();
+    segment.vertices.push_back(v);
+    if (Weld::enabled) {
+        segment.vertexMap[v] = idx;
+    }
+    return idx;
+}
+
+bool isDegenerateTriangle(const SlicedVertex& v1, const SlicedVertex& v2, const SlicedVertex& v3) {
+    Vector3f e1 = v2.position - v1.position;
+    Vector3f e2 = v3.position - v2.position;
+    Vector3f e3 = v1.position - v3.position;
+    const float minLengthSquared = DEGENERATE_EPSILON * DEGENERATE_EPSILON;
+    if (e1.x*e1.x + e1.y*e1.y + e1.z*e1.z < minLengthSquared ||
+        e2.x*e2.x + e2.y*e2.y + e2.z*e2.z < minLengthSquared ||
+        e3.x*e3.x + e3.y*e3.y + e3.z*e3.z < minLengthSquared) {
+        return true;
+    }
+    // Twice the area, compared squared
+    Vector3f n = e1.Cross(e3);
+    return n.x*n.x + n.y*n.y + n.z*n.z < 4.0f * minLengthSquared;
+}
+
+template <typename Weld, typename Degenerates>
+void addTriangle(SegmentBuilder& segment, const SlicedVertex& v1, const SlicedVertex& v2, const SlicedVertex& v3) {
+    if (Degenerates::enabled && isDegenerateTriangle(v1, v2, v3)) {
+        segment.skippedDegenerates++;
+        return;
+    }
+
+    unsigned int idx1 = addVertex<Weld>(segment, v1);
+    unsigned int idx2 = addVertex<Weld>(segment, v2);
+    unsigned int idx3 = addVertex<Weld>(segment, v3);
+
+    segment.indices.push_back(idx1);
+    segment.indices.push_back(idx2);
+    segment.indices.push_back(idx3);
+}
+
+SlicedVertex convertVertex(const Vertex& v) {
+    SlicedVertex sv;
+    sv.position = Vector3f(v.x, v.y, v.z);
+    sv.normal = v.normal;
+    sv.r = v.r;
+    sv.g = v.g;
+    sv.b = v.b;
+    return sv;
+}
+
+// Point where the plane crosses the edge from a to b, given their signed
+// distances. Only called on edges whose ends lie on different sides, so
+// da - db is never zero.
+template <typename Snap>
+SlicedVertex intersectEdge(const SlicedVertex& a, const SlicedVertex& b, float da, float db) {
+    if (Snap::enabled) {
+        if (fabsf(da) < SNAP_EPSILON) {
+            return a;
+        }
+        if (fabsf(db) < SNAP_EPSILON) {
+            return b;
+        }
+    }
+
+    float t = da / (da - db);
+
+    SlicedVertex v;
+    v.position = a.position + (b.position - a.position) * t;
+
+    v.normal.x = a.normal.x + t * (b.normal.x - a.normal.x);
+    v.normal.y = a.normal.y + t * (b.normal.y - a.normal.y);
+    v.normal.z = a.normal.z + t * (b.normal.z - a.normal.z);
+
+    v.r = a.r + t * (b.r - a.r);
+    v.g = a.g + t * (b.g - a.g);
+    v.b = a.b + t * (b.b - a.b);
+
+    float magnitude = sqrtf(v.normal.x * v.normal.x + v.normal.y * v.normal.y + v.normal.z * v.normal.z);
+    if (magnitude > 0.0001f) {
+        v.normal.x /= magnitude;
+        v.normal.y /= magnitude;
+        v.normal.z /= magnitude;
+    }
+    return v;
+}
+
+template <typename Weld, typename Degenerates>
+void createInitialSegment(const OffModel* model, SegmentBuilder& segment) {
+    segment.clear();
+
+    for (int i = 0; i < model->numberOfPolygons; i++) {
+        const Polygon* poly = &model->polygons[i];
+
+        for (int j = 1; j < poly->noSides - 1; j++) {
+            SlicedVertex v1 = convertVertex(model->vertices[poly->v[0]]);
+            SlicedVertex v2 = convertVertex(model->vertices[poly->v[j]]);
+            SlicedVertex v3 = convertVertex(model->vertices[poly->v[j+1]]);
+            addTriangle<Weld, Degenerates>(segment, v1, v2, v3);
+        }
+    }
+}
+
+// Moves a finished builder into the arena and returns its region.
+SliceRegion appendSegment(SegmentArena& arena, const SegmentBuilder& builder) {
+    SliceRegion region;
+    region.firstVertex = arena.vertices.size();
+    region.vertexCount = builder.vertices.size();
+    region.firstIndex = arena.indices.size();
+    region.indexCount = builder.indices.size();
+
+    arena.vertices.insert(arena.vertices.end(), builder.vertices.begin(), builder.vertices.end());
+    arena.indices.insert(arena.indices.end(), builder.indices.begin(), builder.indices.end());
+    return region;
+}
+
+// Splits one region by a plane into posSide and negSide. A vertex is on the
+// positive side when its signed distance is above zero. Returns false if
+// cancelled.
+template <typename Weld, typename Degenerates, typename Snap>
+bool splitRegion(const SegmentArena& arena, const SliceRegion& region, const Plane& plane,
+                 SegmentBuilder& posSide, SegmentBuilder& negSide, const std::atomic<bool>* cancel) {
+    const SlicedVertex* vertices = arena.vertices.data() + region.firstVertex;
+    const unsigned int* indices = arena.indices.data() + region.firstIndex;
+
+    for (size_t i = 0; i < region.indexCount; i += 3) {
+        if (cancel && (i % 12288) == 0 && cancel->load()) {
+            return false;
+        }
+
+        const SlicedVertex* v[3] = {&vertices[indices[i]], &vertices[indices[i+1]], &vertices[indices[i+2]]};
+        float d[3] = {plane.evaluate(v[0]->position), plane.evaluate(v[1]->position), plane.evaluate(v[2]->position)};
+        int positive = (d[0] > 0.0f ? 1 : 0) | (d[1] > 0.0f ? 2 : 0) | (d[2] > 0.0f ? 4 : 0);
+
+        if (positive == 0) {
+            addTriangle<Weld, Degenerates>(negSide, *v[0], *v[1], *v[2]);
+            continue;
+        }
+        if (positive == 7) {
+            addTriangle<Weld, Degenerates>(posSide, *v[0], *v[1], *v[2]);
+            continue;
+        }
+
+        // Rotate so a is the vertex alone on its side, keeping the winding
+        bool lonePositive = positive == 1 || positive == 2 || positive == 4;
+        int mask = lonePositive ? positive : (~positive & 7);
+        int lone = mask == 1 ? 0 : (mask == 2 ? 1 : 2);
+        int next = (lone + 1) % 3, last = (lone + 2) % 3;
+        const SlicedVertex& a = *v[lone];
+        const SlicedVertex& b = *v[next];
+        const SlicedVertex& c = *v[last];
+
+        SlicedVertex ab = intersectEdge<Snap>(a, b, d[lone], d[next]);
+        SlicedVertex ac = intersectEdge<Snap>(a, c, d[lone], d[last]);
+
+        if (lonePositive) {
+            addTriangle<Weld, Degenerates>(posSide, a, ab, ac);
+            addTriangle<Weld, Degenerates>(negSide, b, c, ac);
+            addTriangle<Weld, Degenerates>(negSide, b, ac, ab);
+        } else {
+            addTriangle<Weld, Degenerates>(negSide, a, ab, ac);
+            addTriangle<Weld, Degenerates>(posSide, b, c, ab);
+            addTriangle<Weld, Degenerates>(posSide, ab, c, ac);
+        }
+    }
+    return true;
+}
+
+// Triangulates the model and splits it by each plane in turn. Every pass
+// reads the previous arena and writes a fresh one, so no segment geometry is
+// copied once it has been built. Regions come out positive side first for
+// each parent, with empty sides dropped. Planes past MAX_REGION_PLANES are
+// ignored.
+//
+// When cancel is given it is polled between segments and every few thousand
+// triangles; a cancelled slice returns false and leaves arena and regions
+// untouched.
+template <typename Weld, typename Degenerates, typename Snap, typename Regions = SerialRegions>
+bool slicePolygons(const OffModel* model, const std::vector<Plane>& planes,
+                   std::shared_ptr<const SegmentArena>& arena, std::vector<SliceRegion>& regions,
+                   const std::atomic<bool>* cancel = nullptr) {
+    size_t planeCount = planes.size();
+    if (planeCount > MAX_REGION_PLANES) {
+        LOG_WARN("Warning: Only the first %zu planes are used for slicing\n", MAX_REGION_PLANES);
+        planeCount = MAX_REGION_PLANES;
+    }
+
+    // Positive and negative side of every region in a batch
+    std::vector<SegmentBuilder> builders(2);
+    createInitialSegment<Weld, Degenerates>(model, builders[0]);
+    if (cancel && cancel->load()) {
+        return false;
+    }
+
+    SegmentArena current;
+    std::vector<SliceRegion> currentRegions(1, appendSegment(current, builders[0]));
+
+    for (size_t planeIndex = 0; planeIndex < planeCount; planeIndex++) {
+        const Plane& plane = planes[planeIndex];
+        std::vector<SliceRegion> newRegions;
+        newRegions.reserve(currentRegions.size() * 2);
+
+        SegmentArena newArena;
+        newArena.vertices.reserve(current.vertices.size() + current.vertices.size() / 8);
+        newArena.indices.reserve(current.indices.size() + current.indices.size() / 8);
+
+        size_t batch = std::max<size_t>(1, Regions::batchSize(currentRegions.size()));
+        for (size_t first = 0; first < currentRegions.size(); first += batch) {
+            size_t count = std::min(batch, currentRegions.size() - first);
+            if (builders.size() < count * 2) {
+                builders.resize(count * 2);
+            }
+
+            std::atomic<bool> completed(true);
+            Regions::forEach(count, [&](size_t i) {
+                SegmentBuilder& posSide = builders[i * 2];
+                SegmentBuilder& negSide = builders[i * 2 + 1];
+                posSide.clear();
+                negSide.clear();
+                if (!splitRegion<Weld, Degenerates, Snap>(current, currentRegions[first + i], plane, posSide, negSide, cancel)) {
+                    completed = false;
+                }
+            });
+            if (!completed) {
+                return false;
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                const SliceRegion& region = currentRegions[first + i];
+                const SegmentBuilder& posSide = builders[i * 2];
+                const SegmentBuilder& negSide = builders[i * 2 + 1];
+
+                if (!posSide.vertices.empty()) {
+                    SliceRegion child = appendSegment(newArena, posSide);
+                    child.regionCode = region.regionCode | (1u << planeIndex);
+                    child.regionLength = planeIndex + 1;
+                    newRegions.push_back(child);
+                }
+
+                if (!negSide.vertices.empty()) {
+                    SliceRegion child = appendSegment(newArena, negSide);
+                    child.regionCode = region.regionCode;
+                    child.regionLength = planeIndex + 1;
+                    newRegions.push_back(child);
+                }
+            }
+        }
+
+        current = std::move(newArena);
+        currentRegions = std::move(newRegions);
+    }
+
+    size_t skipped = 0;
+    for (const SegmentBuilder& builder : builders) {
+        skipped += builder.skippedDegenerates;
+    }
+    LOG_COUNT(LOG_SLICES, 1);
+    LOG_COUNT(LOG_SEGMENTS, currentRegions.size());
+    if (skipped > 0) {
+        LOG_WARN_EVERY(LOG_DEGENERATE_TRIANGLES, skipped, "Warning: Skipped %zu degenerate triangles", skipped);
+    }
+    LOG_SUMMARY(LOG_STAGE_SLICE, "%zu planes, %zu segments, %zu triangles, %zu degenerate skipped",
+                planeCount, currentRegions.size(), current.indices.size() / 3, skipped);
+
+    arena = std::make_shared<const SegmentArena>(std::move(current));
+    regions = std::move(currentRegions);
+    return true;
+}
+
+#endif
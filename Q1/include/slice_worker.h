@@ -0,0 +1,153 @@
+#ifndef SLICE_WORKER_H
+#define SLICE_WORKER_H
+
+#include "mesh_slicer.h"
+#include "plane.h"
+#include "profiler.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Runs sliceWithPlanes off the render thread. The render thread owns the
+// front MeshSlicerState (g_slicerState); the worker fills the back buffer
+// and marks it ready, and the render thread swaps the two at the start of a
+// frame. A new request bumps the generation and cancels whatever is in
+// flight, so only the most recent plane set is ever published.
+struct SliceWorker {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Latest request, guarded by mutex.
+    bool hasRequest = false;
+    std::vector<Plane> requestPlanes;
+    OffModel* requestModel = nullptr;
+    unsigned int requestGeneration = 0;
+
+    // Back buffer. The worker only writes it while ready is false; the render
+    // thread only swaps it while ready is true.
+    MeshSlicerState back;
+    bool ready = false;
+    unsigned int readyGeneration = 0;
+    double readySliceMs = 0.0;
+
+    std::atomic<bool> cancel;
+    std::atomic<bool> busy;
+
+    // Called on the worker thread after a result is published, e.g. to wake
+    // a render loop that is waiting for events.
+    void (*notify)() = nullptr;
+
+    SliceWorker() : cancel(false), busy(false) {}
+};
+
+void sliceWorkerLoop(SliceWorker* worker) {
+    while (true) {
+        std::vector<Plane> planes;
+        OffModel* model;
+        unsigned int generation;
+
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->wake.wait(lock, [worker] { return worker->stopping || worker->hasRequest; });
+            if (worker->stopping) {
+                return;
+            }
+
+            planes.swap(worker->requestPlanes);
+            model = worker->requestModel;
+            generation = worker->requestGeneration;
+            worker->hasRequest = false;
+            worker->ready = false;
+            worker->cancel = false;
+            worker->busy = true;
+        }
+
+        double startUs = profilerNowUs(g_profiler);
+        worker->back.model = model;
+        bool completed = sliceWithPlanes(worker->back, planes, &worker->cancel);
+        double sliceUs = profilerNowUs(g_profiler) - startUs;
+        profileRecord(g_profiler, completed ? "Slice" : "Slice (cancelled)", startUs, sliceUs);
+
+        bool published = false;
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            if (completed && generation == worker->requestGeneration) {
+                worker->ready = true;
+                worker->readyGeneration = generation;
+                worker->readySliceMs = sliceUs / 1000.0;
+                published = true;
+            }
+            worker->busy = worker->hasRequest;
+        }
+        if (published && worker->notify) {
+            worker->notify();
+        }
+    }
+}
+
+void startSliceWorker(SliceWorker& worker) {
+    worker.stopping = false;
+    worker.thread = std::thread(sliceWorkerLoop, &worker);
+}
+
+void stopSliceWorker(SliceWorker& worker) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.stopping = true;
+        worker.cancel = true;
+    }
+    worker.wake.notify_one();
+    if (worker.thread.joinable()) {
+        worker.thread.join();
+    }
+}
+
+// Queues a slice of a snapshot of planes, replacing any request that has not
+// started and cancelling the one that has. Returns the request's generation.
+unsigned int requestSlice(SliceWorker& worker, OffModel* model, const std::vector<Plane>& planes) {
+    unsigned int generation;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.requestPlanes = planes;
+        worker.requestModel = model;
+        generation = ++worker.requestGeneration;
+        worker.hasRequest = true;
+        worker.ready = false;
+        worker.cancel = true;
+        worker.busy = true;
+    }
+    worker.wake.notify_one();
+    return generation;
+}
+
+// Drops any pending or in-flight slice without publishing it.
+void cancelSlice(SliceWorker& worker) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.requestGeneration++;
+    worker.hasRequest = false;
+    worker.ready = false;
+    worker.cancel = true;
+}
+
+// Called once per frame on the render thread. If a finished slice is waiting
+// it is swapped into front and true is returned; the old front becomes the
+// worker's next back buffer.
+bool pollSliceResult(SliceWorker& worker, MeshSlicerState& front, double* sliceMs = nullptr) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.ready) {
+        return false;
+    }
+
+    std::swap(front, worker.back);
+    worker.ready = false;
+    if (sliceMs) {
+        *sliceMs = worker.readySliceMs;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef SLICER_GPU_H
+#define SLICER_GPU_H
+
+#include "mesh_slicer.h"
+#include "frustum.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <memory>
+
+// Where a segment lives inside the persistent sliced-mesh buffers. Indices are
+// stored segment-local and drawn with baseVertex.
+struct SegmentGPURange {
+    GLint baseVertex;
+    GLsizei vertexCount;
+    size_t firstIndex;
+    GLsizei indexCount;
+};
+
+struct SlicedGPUBuffers {
+    GLuint vao = 0, vbo = 0, ibo = 0;
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
+    size_t vertexUsed = 0;
+    size_t indexUsed = 0;
+    bool persistent = false;
+    Vertex* mappedVertices = nullptr;
+    unsigned int* mappedIndices = nullptr;
+    GLsync drawFence = 0;
+    GLuint offsetBuffer = 0, offsetTexture = 0;
+    size_t offsetCapacity = 0;
+    std::vector<SegmentGPURange> ranges;
+    std::vector<Vertex> staging;
+    std::shared_ptr<const SegmentArena> uploadedArena;  // arena the buffers currently hold
+    double lastUploadMs = 0.0;
+    size_t lastUploadedSegments = 0;
+    
+    // Per-frame multi-draw arguments for the segments that survive culling
+    std::vector<GLsizei> drawCounts;
+    std::vector<const void*> drawOffsets;
+    std::vector<GLint> drawBaseVertices;
+    size_t lastDrawnSegments = 0;
+    SpheresSoA cullSpheres;
+    std::vector<unsigned char> cullVisible;
+};
+
+void setupSlicedVertexLayout() {
+    glEnableVertexAttribArray(0); // Position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+    
+    glEnableVertexAttribArray(1); // Color
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, r));
+    
+    glEnableVertexAttribArray(2); // Normal
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    
+    glEnableVertexAttribArray(3); // Segment index, carried in the otherwise unused numIcidentTri slot
+    glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, numIcidentTri));
+}
+
+// Allocates a new buffer of newBytes and carries over the first keepBytes of
+// the old one. With ARB_buffer_storage the buffer is immutable and stays
+// mapped for its whole lifetime, so growing means replacing it. If the new
+// buffer cannot be mapped, persistent is cleared and a plain buffer is used.
+void growSlicedBuffer(GLuint& buffer, size_t keepBytes, size_t newBytes, bool& persistent, void** mapped) {
+    GLuint newBuffer = 0;
+    void* newMapped = nullptr;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    
+    if (persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, newBytes, nullptr, flags);
+        newMapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, newBytes, flags);
+        if (!newMapped) {
+            LOG_WARN("Warning: could not map a %zu byte sliced-mesh buffer; uploading with glBufferSubData\n", newBytes);
+            glDeleteBuffers(1, &newBuffer);
+            glGenBuffers(1, &newBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+            persistent = false;
+        }
+    }
+    if (!persistent) {
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_DYNAMIC_DRAW);
+    }
+    
+    if (buffer != 0) {
+        if (keepBytes > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keepBytes);
+        }
+        if (*mapped) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    
+    *mapped = newMapped;
+    buffer = newBuffer;
+}
+
+// Makes room for the given number of vertices and indices, doubling capacity
+// so repeated slicing settles on a fixed allocation. Only the used prefix is
+// copied across when the buffers have to grow.
+void reserveSlicedBuffers(SlicedGPUBuffers& gpu, size_t vertices, size_t indices) {
+    if (gpu.vao == 0) {
+        glGenVertexArrays(1, &gpu.vao);
+        gpu.persistent = GLEW_ARB_buffer_storage;
+    }
+    
+    glBindVertexArray(gpu.vao);
+    
+    if (vertices > gpu.vertexCapacity || gpu.vbo == 0) {
+        size_t capacity = std::max<size_t>(gpu.vertexCapacity * 2, 1024);
+        while (capacity < vertices) capacity *= 2;
+        
+        growSlicedBuffer(gpu.vbo, gpu.vertexUsed * sizeof(Vertex), capacity * sizeof(Vertex),
+                         gpu.persistent, (void**)&gpu.mappedVertices);
+        gpu.vertexCapacity = capacity;
+        
+        glBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+        setupSlicedVertexLayout();
+    }
+    
+    if (indices > gpu.indexCapacity || gpu.ibo == 0) {
+        size_t capacity = std::max<size_t>(gpu.indexCapacity * 2, 3072);
+        while (capacity < indices) capacity *= 2;
+        
+        growSlicedBuffer(gpu.ibo, gpu.indexUsed * sizeof(unsigned int), capacity * sizeof(unsigned int),
+                         gpu.persistent, (void**)&gpu.mappedIndices);
+        gpu.indexCapacity = capacity;
+        
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.ibo);
+    }
+    
+    // When one buffer could not be mapped, the other may still be an
+    // immutable mapped one, which glBufferSubData cannot write. Replace it.
+    if (!gpu.persistent && gpu.mappedVertices) {
+        growSlicedBuffer(gpu.vbo, gpu.vertexUsed * sizeof(Vertex), gpu.vertexCapacity * sizeof(Vertex),
+                         gpu.persistent, (void**)&gpu.mappedVertices);
+        glBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+        setupSlicedVertexLayout();
+    }
+    if (!gpu.persistent && gpu.mappedIndices) {
+        growSlicedBuffer(gpu.ibo, gpu.indexUsed * sizeof(unsigned int), gpu.indexCapacity * sizeof(unsigned int),
+                         gpu.persistent, (void**)&gpu.mappedIndices);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.ibo);
+    }
+    
+    glBindVertexArray(0);
+}
+
+void writeSegmentToGPU(SlicedGPUBuffers& gpu, const MeshSegment& segment, size_t segmentIndex, const SegmentGPURange& range) {
+    const unsigned int* indices = segmentIndices(g_slicerState, segment);
+    packSegmentVertices(g_slicerState, segment, segmentIndex, gpu.staging);
+    
+    size_t vertexBytes = gpu.staging.size() * sizeof(Vertex);
+    size_t indexBytes = segment.indexCount * sizeof(unsigned int);
+    
+    if (gpu.persistent) {
+        memcpy(gpu.mappedVertices + range.baseVertex, gpu.staging.data(), vertexBytes);
+        memcpy(gpu.mappedIndices + range.firstIndex, indices, indexBytes);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * sizeof(Vertex), vertexBytes, gpu.staging.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, gpu.ibo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(unsigned int), indexBytes, indices);
+    }
+}
+
+// Blocks until the GPU has finished the last draw from the mapped buffers,
+// so they can be overwritten. Falls back to glFinish if the wait fails.
+void waitForSlicedDraws(SlicedGPUBuffers& gpu) {
+    GLenum result = GL_TIMEOUT_EXPIRED;
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(gpu.drawFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+    if (result == GL_WAIT_FAILED) {
+        glFinish();
+    }
+}
+
+// Packs the current segments into the persistent sliced-mesh buffers from the
+// start. The buffers only grow, so slicing again usually reuses them.
+void uploadToGPU(SlicedGPUBuffers& gpu) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<MeshSegment>& segments = g_slicerState.segments;
+    
+    if (gpu.persistent && gpu.drawFence) {
+        waitForSlicedDraws(gpu);
+    }
+    
+    size_t totalVertices = 0, totalIndices = 0;
+    for (const MeshSegment& segment : segments) {
+        totalVertices += segment.vertexCount;
+        totalIndices += segment.indexCount;
+    }
+    
+    gpu.vertexUsed = 0;
+    gpu.indexUsed = 0;
+    reserveSlicedBuffers(gpu, totalVertices, totalIndices);
+    gpu.ranges.resize(segments.size());
+    
+    for (size_t segIdx = 0; segIdx < segments.size(); segIdx++) {
+        const MeshSegment& segment = segments[segIdx];
+        SegmentGPURange& range = gpu.ranges[segIdx];
+        range.baseVertex = gpu.vertexUsed;
+        range.vertexCount = segment.vertexCount;
+        range.firstIndex = gpu.indexUsed;
+        range.indexCount = segment.indexCount;
+        gpu.vertexUsed += segment.vertexCount;
+        gpu.indexUsed += segment.indexCount;
+        
+        writeSegmentToGPU(gpu, segment, segIdx, range);
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    gpu.lastUploadMs = std::chrono::duration<double, std::milli>(end - start).count();
+    gpu.lastUploadedSegments = segments.size();
+    gpu.uploadedArena = g_slicerState.arena;
+    
+    LOG_COUNT(LOG_UPLOADS, 1);
+    LOG_COUNT(LOG_UPLOADED_VERTICES, totalVertices);
+    LOG_SUMMARY(LOG_STAGE_UPLOAD, "%zu segments in %.2f ms (%zu vertices, %zu indices)",
+           segments.size(), gpu.lastUploadMs, gpu.vertexUsed, gpu.indexUsed);
+}
+
+// True when the buffers already hold the current slice, e.g. after a cache
+// hit on the last uploaded result, so it need not be uploaded again.
+bool adoptRetainedBuffers(SlicedGPUBuffers& gpu) {
+    const std::vector<MeshSegment>& segments = g_slicerState.segments;
+    if (!gpu.uploadedArena || gpu.uploadedArena != g_slicerState.arena || gpu.ranges.size() != segments.size()) {
+        return false;
+    }
+    
+    gpu.lastUploadMs = 0.0;
+    gpu.lastUploadedSegments = 0;
+    return true;
+}
+
+// Draws every segment whose bounding sphere, moved by its explosion offset,
+// touches the frustum (all of them when frustum is null), as one multi-draw.
+// The frustum must be in the mesh's object space.
+void drawSlicedSegments(SlicedGPUBuffers& gpu, const Frustum* frustum = nullptr) {
+    const std::vector<MeshSegment>& segments = g_slicerState.segments;
+    
+    gpu.drawCounts.clear();
+    gpu.drawOffsets.clear();
+    gpu.drawBaseVertices.clear();
+    
+    if (frustum) {
+        gpu.cullSpheres.resize(segments.size());
+        for (size_t i = 0; i < segments.size(); i++) {
+            Vector3f center = segments[i].boundsCenter + segments[i].offset;
+            gpu.cullSpheres.x[i] = center.x;
+            gpu.cullSpheres.y[i] = center.y;
+            gpu.cullSpheres.z[i] = center.z;
+            gpu.cullSpheres.radius[i] = segments[i].boundsRadius;
+        }
+        spheresInFrustum(*frustum, gpu.cullSpheres, gpu.cullVisible);
+    }
+    
+    for (size_t i = 0; i < gpu.ranges.size(); i++) {
+        const SegmentGPURange& range = gpu.ranges[i];
+        if (range.indexCount == 0) {
+            continue;
+        }
+        if (frustum && i < segments.size() && !gpu.cullVisible[i]) {
+            continue;
+        }
+        gpu.drawCounts.push_back(range.indexCount);
+        gpu.drawOffsets.push_back((const void*)(range.firstIndex * sizeof(unsigned int)));
+        gpu.drawBaseVertices.push_back(range.baseVertex);
+    }
+    gpu.lastDrawnSegments = gpu.drawCounts.size();
+    
+    glBindVertexArray(gpu.vao);
+    if (!gpu.drawCounts.empty()) {
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, gpu.drawCounts.data(), GL_UNSIGNED_INT,
+                                      (void* const*)gpu.drawOffsets.data(), (GLsizei)gpu.drawCounts.size(),
+                                      gpu.drawBaseVertices.data());
+    }
+    
+    if (gpu.persistent) {
+        if (gpu.drawFence) {
+            glDeleteSync(gpu.drawFence);
+        }
+        gpu.drawFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void destroySlicedBuffers(SlicedGPUBuffers& gpu) {
+    if (gpu.drawFence) {
+        glDeleteSync(gpu.drawFence);
+    }
+    if (gpu.vao != 0) {
+        glDeleteVertexArrays(1, &gpu.vao);
+        glDeleteBuffers(1, &gpu.vbo);
+        glDeleteBuffers(1, &gpu.ibo);
+    }
+    if (gpu.offsetTexture != 0) {
+        glDeleteTextures(1, &gpu.offsetTexture);
+        glDeleteBuffers(1, &gpu.offsetBuffer);
+    }
+    gpu = SlicedGPUBuffers();
+}
+
+// Writes the per-segment offsets into the small buffer texture the vertex
+// shader reads them from, indexed by the segment attribute.
+void uploadSegmentOffsets(SlicedGPUBuffers& gpu) {
+    const std::vector<MeshSegment>& segments = g_slicerState.segments;
+    
+    if (gpu.offsetTexture == 0) {
+        glGenBuffers(1, &gpu.offsetBuffer);
+        glGenTextures(1, &gpu.offsetTexture);
+    }
+    
+    std::vector<float> data(std::max<size_t>(segments.size(), 1) * 4, 0.0f);
+    for (size_t i = 0; i < segments.size(); i++) {
+        data[i * 4 + 0] = segments[i].offset.x;
+        data[i * 4 + 1] = segments[i].offset.y;
+        data[i * 4 + 2] = segments[i].offset.z;
+    }
+    
+    glBindBuffer(GL_TEXTURE_BUFFER, gpu.offsetBuffer);
+    if (data.size() > gpu.offsetCapacity) {
+        gpu.offsetCapacity = data.size();
+        glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(float), data.data(), GL_DYNAMIC_DRAW);
+        
+        glBindTexture(GL_TEXTURE_BUFFER, gpu.offsetTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, gpu.offsetBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    } else {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, data.size() * sizeof(float), data.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef TASK_SYSTEM_H
+#define TASK_SYSTEM_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+// Work-stealing task pool shared by every CPU stage of Q1 (loading, normals,
+// slicing, contours, batch export). Each worker owns a deque: it pushes and
+// pops its own tasks at the back and steals from the front of the others, so
+// the oldest and, for parallelFor, largest pieces of work are the ones that
+// move between threads.
+//
+// Tasks belong to a TaskGroup. waitForGroup runs queued tasks while it waits
+// instead of blocking, so tasks may spawn and wait for nested groups, and
+// threads outside the pool (the render thread, the slice worker) help with
+// the work they are waiting for. A group may carry a cancel token; once it is
+// set, tasks of the group that have not started are dropped.
+//
+// With no workers (before startTaskSystem, or on one core) everything runs
+// inline on the calling thread.
+
+struct TaskGroup;
+
+struct Task {
+    std::function<void()> run;
+    TaskGroup* group;
+};
+
+struct TaskGroup {
+    std::atomic<int> pending;
+    const std::atomic<bool>* cancel;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    explicit TaskGroup(const std::atomic<bool>* cancelToken = nullptr) : pending(0), cancel(cancelToken) {}
+};
+
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+struct TaskSystem {
+    std::vector<std::thread> threads;
+    std::unique_ptr<TaskQueue[]> queues;  // one per worker
+    unsigned int workerCount = 0;
+    std::atomic<bool> stopping;
+    std::atomic<int> queued;              // tasks sitting in any queue
+    std::atomic<unsigned int> nextQueue;  // round robin for submissions from outside the pool
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    // Statistics for the profiler overlay.
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> busyUs;  // time workers spent running tasks
+    std::atomic<uint64_t> tasksRun;
+    std::atomic<uint64_t> steals;
+    uint64_t sampleBusyUs = 0;
+    double sampleStartUs = 0.0;
+    float utilization = 0.0f;
+
+    TaskSystem() : stopping(false), queued(0), nextQueue(0), busyUs(0), tasksRun(0), steals(0) {}
+    ~TaskSystem();
+};
+
+extern TaskSystem g_tasks;
+
+// Index of the calling thread's queue in the pool it works for, or -1.
+int& currentTaskWorker() {
+    static thread_local int index = -1;
+    return index;
+}
+
+TaskSystem*& currentTaskSystem() {
+    static thread_local TaskSystem* system = nullptr;
+    return system;
+}
+
+double taskNowUs(const TaskSystem& system) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - system.origin).count();
+}
+
+// Threads that run tasks, counting the thread that waits for them.
+unsigned int taskThreadCount(const TaskSystem& system) {
+    return system.workerCount + 1;
+}
+
+bool groupCancelled(const TaskGroup& group) {
+    return group.cancel && group.cancel->load(std::memory_order_relaxed);
+}
+
+// The count only drops under the group's mutex, so a waiter that sees zero
+// and then takes the mutex knows no task still touches the group.
+void finishTask(TaskGroup& group) {
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (--group.pending == 0) {
+        group.done.notify_all();
+    }
+}
+
+void runTask(Task& task) {
+    if (!groupCancelled(*task.group)) {
+        task.run();
+    }
+    finishTask(*task.group);
+}
+
+// Takes a task from the back of the worker's own queue, or steals one from
+// the front of another.
+bool popTask(TaskSystem& system, int self, Task& task) {
+    if (system.workerCount == 0 || system.queued.load() == 0) {
+        return false;
+    }
+    if (self >= 0) {
+        TaskQueue& own = system.queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            system.queued--;
+            return true;
+        }
+    }
+
+    unsigned int start = self >= 0 ? self + 1 : system.nextQueue.load();
+    for (unsigned int i = 0; i < system.workerCount; i++) {
+        unsigned int victim = (start + i) % system.workerCount;
+        if ((int)victim == self) {
+            continue;
+        }
+        TaskQueue& queue = system.queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            system.queued--;
+            system.steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void taskWorkerLoop(TaskSystem* system, int index) {
+    currentTaskWorker() = index;
+    currentTaskSystem() = system;
+
+    while (true) {
+        Task task;
+        if (popTask(*system, index, task)) {
+            double startUs = taskNowUs(*system);
+            runTask(task);
+            system->busyUs += (uint64_t)(taskNowUs(*system) - startUs);
+            system->tasksRun++;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(system->sleepMutex);
+        system->wake.wait(lock, [system] { return system->stopping || system->queued.load() > 0; });
+        if (system->stopping && system->queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+void stopTaskSystem(TaskSystem& system);
+
+// Starts threadCount - 1 workers (0 for one thread per core); the thread
+// that waits on a group makes up the last one. Restarting resizes the pool.
+void startTaskSystem(TaskSystem& system, unsigned int threadCount = 0) {
+    stopTaskSystem(system);
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    system.workerCount = threadCount - 1;
+    system.stopping = false;
+    system.queues.reset(system.workerCount > 0 ? new TaskQueue[system.workerCount] : nullptr);
+    for (unsigned int i = 0; i < system.workerCount; i++) {
+        system.threads.push_back(std::thread(taskWorkerLoop, &system, (int)i));
+    }
+}
+
+// Runs whatever is still queued, then joins the workers.
+void stopTaskSystem(TaskSystem& system) {
+    {
+        std::lock_guard<std::mutex> lock(system.sleepMutex);
+        system.stopping = true;
+    }
+    system.wake.notify_all();
+    for (std::thread& thread : system.threads) {
+        // exit() called from a task ends up here on a worker thread
+        if (thread.get_id() == std::this_thread::get_id()) {
+            thread.detach();
+        } else if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    system.threads.clear();
+    system.workerCount = 0;
+    system.queues.reset();
+}
+
+TaskSystem::~TaskSystem() {
+    stopTaskSystem(*this);
+}
+
+// Queues run as a task of group. Workers push onto their own queue; other
+// threads spread their tasks over the workers' queues.
+void spawnTask(TaskSystem& system, TaskGroup& group, std::function<void()> run) {
+    group.pending++;
+    Task task = {std::move(run), &group};
+    if (system.workerCount == 0) {
+        runTask(task);
+        return;
+    }
+
+    int self = currentTaskSystem() == &system ? currentTaskWorker() : -1;
+    unsigned int index = self >= 0 ? (unsigned int)self : system.nextQueue++ % system.workerCount;
+    {
+        std::lock_guard<std::mutex> lock(system.queues[index].mutex);
+        system.queues[index].tasks.push_back(std::move(task));
+    }
+    system.queued++;
+    {
+        std::lock_guard<std::mutex> lock(system.sleepMutex);
+    }
+    system.wake.notify_one();
+}
+
+// Returns once every task of the group has finished, running queued tasks
+// (of any group) in the meantime. Returns false if the group was cancelled.
+bool waitForGroup(TaskSystem& system, TaskGroup& group) {
+    int self = currentTaskSystem() == &system ? currentTaskWorker() : -1;
+    while (group.pending.load() > 0) {
+        Task task;
+        if (popTask(system, self, task)) {
+            runTask(task);
+            continue;
+        }
+        // Nothing to help with: sleep until the group finishes, checking now
+        // and then for tasks that running ones have spawned.
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.done.wait_for(lock, std::chrono::milliseconds(1), [&group] { return group.pending.load() == 0; });
+    }
+    std::lock_guard<std::mutex> lock(group.mutex);
+    return !groupCancelled(group);
+}
+
+void parallelForRange(TaskSystem& system, TaskGroup& group, size_t begin, size_t end, size_t grain,
+                      const std::function<void(size_t, size_t)>& body) {
+    // Hand the upper half to a thief and keep splitting the lower one, so a
+    // stolen task is always the largest piece still unclaimed.
+    while (end - begin > grain) {
+        size_t middle = begin + (end - begin) / 2;
+        spawnTask(system, group, [&system, &group, middle, end, grain, &body]() {
+            parallelForRange(system, group, middle, end, grain, body);
+        });
+        end = middle;
+    }
+    if (!groupCancelled(group)) {
+        body(begin, end);
+    }
+}
+
+// Calls body on disjoint subranges of [begin, end) of at most grain items,
+// in parallel, and returns when all are done. Ranges not yet started when
+// cancel is set are skipped; returns false in that case.
+bool parallelFor(TaskSystem& system, size_t begin, size_t end, size_t grain,
+                 const std::function<void(size_t, size_t)>& body, const std::atomic<bool>* cancel = nullptr) {
+    grain = std::max<size_t>(1, grain);
+    if (system.workerCount == 0 || end - begin <= grain) {
+        for (size_t first = begin; first < end; first += grain) {
+            if (cancel && cancel->load()) {
+                return false;
+            }
+            body(first, std::min(end, first + grain));
+        }
+        return !(cancel && cancel->load());
+    }
+
+    TaskGroup group(cancel);
+    parallelForRange(system, group, begin, end, grain, body);
+    return waitForGroup(system, group);
+}
+
+// Grain that gives every thread about piecesPerThread pieces of a range of
+// count items, but no piece smaller than minGrain.
+size_t taskGrain(const TaskSystem& system, size_t count, size_t minGrain, size_t piecesPerThread = 4) {
+    size_t pieces = taskThreadCount(system) * piecesPerThread;
+    return std::max(minGrain, (count + pieces - 1) / pieces);
+}
+
+// Share of the workers' time spent in tasks, averaged over about a quarter
+// of a second. Call from one thread only (the overlay).
+float sampleTaskUtilization(TaskSystem& system) {
+    double nowUs = taskNowUs(system);
+    double elapsedUs = nowUs - system.sampleStartUs;
+    if (elapsedUs < 250000.0) {
+        return system.utilization;
+    }
+    uint64_t busy = system.busyUs.load();
+    system.utilization = system.workerCount > 0
+        ? (float)((busy - system.sampleBusyUs) / (elapsedUs * system.workerCount)) : 0.0f;
+    system.sampleBusyUs = busy;
+    system.sampleStartUs = nowUs;
+    return system.utilization;
+}
+
+#endif
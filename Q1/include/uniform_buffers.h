@@ -0,0 +1,147 @@
+#ifndef UNIFORM_BUFFERS_H
+#define UNIFORM_BUFFERS_H
+
+#include <GL/glew.h>
+#include <string.h>
+#include <stddef.h>
+#include <vector>
+#include <algorithm>
+#include "math_utils.h"
+#include "plane.h"
+#include "light.h"
+#include "log.h"
+
+// Per-frame shader state lives in two std140 uniform blocks shared by every
+// stage: FrameData (matrices, view position, preview planes), rewritten with
+// one glBufferSubData per frame, and LightData, rewritten only when a light
+// changes. The structs below mirror the std140 layout of the blocks in
+// shaders/shader.{vs,fs}; keep them in sync.
+
+const GLuint FRAME_DATA_BINDING = 0;
+const GLuint LIGHT_DATA_BINDING = 1;
+
+struct FrameUniforms {
+    float world[16];          // row_major in the shader, so Matrix4f rows go in as-is
+    float view[16];
+    float projection[16];
+    float viewPos[3];
+    float pad0;
+    float planeEquations[4][4];
+    GLint planeEnabled[4];
+    GLint planeSlicingEnabled;
+    GLint pad1[3];
+};
+
+// Only enabled lights are uploaded, packed from the front, so the shader
+// loops over exactly lightCount of them.
+struct LightUniform {
+    float position[3];
+    float radius;
+    float color[3];
+    float intensity;
+};
+
+struct LightUniforms {
+    GLint lightCount;
+    GLint pad[3];
+    LightUniform lights[MAX_LIGHTS];
+};
+
+struct UniformBuffers {
+    GLuint frameUBO = 0;
+    GLuint lightUBO = 0;
+    FrameUniforms frame;
+    LightUniforms lightData;  // copy of what lightUBO holds
+};
+
+// Binds the program's blocks to their fixed binding points. A block the
+// compiler dropped because no stage reads it is simply skipped.
+void bindUniformBlocks(GLuint program) {
+    GLuint frameIndex = glGetUniformBlockIndex(program, "FrameData");
+    if (frameIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, frameIndex, FRAME_DATA_BINDING);
+    }
+    GLuint lightIndex = glGetUniformBlockIndex(program, "LightData");
+    if (lightIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, lightIndex, LIGHT_DATA_BINDING);
+    }
+}
+
+void createUniformBuffers(UniformBuffers& ubos) {
+    memset(&ubos.frame, 0, sizeof(ubos.frame));
+    memset(&ubos.lightData, 0, sizeof(ubos.lightData));
+
+    glGenBuffers(1, &ubos.frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubos.frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &ubos.frame, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &ubos.lightUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubos.lightUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, ubos.frameUBO);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_DATA_BINDING, ubos.lightUBO);
+}
+
+void destroyUniformBuffers(UniformBuffers& ubos) {
+    glDeleteBuffers(1, &ubos.frameUBO);
+    glDeleteBuffers(1, &ubos.lightUBO);
+    ubos.frameUBO = ubos.lightUBO = 0;
+}
+
+void setFramePlane(FrameUniforms& frame, int index, const Plane& plane) {
+    frame.planeEquations[index][0] = plane.a;
+    frame.planeEquations[index][1] = plane.b;
+    frame.planeEquations[index][2] = plane.c;
+    frame.planeEquations[index][3] = plane.d;
+    frame.planeEnabled[index] = plane.enabled;
+}
+
+void uploadFrameUniforms(UniformBuffers& ubos, const Matrix4f& world, const Matrix4f& view,
+                         const Matrix4f& projection, const Vector3f& viewPos) {
+    memcpy(ubos.frame.world, &world.m[0][0], sizeof(ubos.frame.world));
+    memcpy(ubos.frame.view, &view.m[0][0], sizeof(ubos.frame.view));
+    memcpy(ubos.frame.projection, &projection.m[0][0], sizeof(ubos.frame.projection));
+    ubos.frame.viewPos[0] = viewPos.x;
+    ubos.frame.viewPos[1] = viewPos.y;
+    ubos.frame.viewPos[2] = viewPos.z;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, ubos.frameUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &ubos.frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void uploadLightUniforms(UniformBuffers& ubos, const std::vector<Light>& lights) {
+    LightUniforms& data = ubos.lightData;
+    int count = 0;
+    size_t leftOut = 0;
+    for (const Light& light : lights) {
+        if (!light.enabled || light.intensity <= 0.0f) {
+            continue;
+        }
+        if (count == MAX_LIGHTS) {
+            leftOut++;
+            continue;
+        }
+        LightUniform& l = data.lights[count++];
+        l.position[0] = light.position.x;
+        l.position[1] = light.position.y;
+        l.position[2] = light.position.z;
+        l.radius = std::max(light.radius, 0.0f);
+        l.color[0] = light.color.x;
+        l.color[1] = light.color.y;
+        l.color[2] = light.color.z;
+        l.intensity = light.intensity;
+    }
+    data.lightCount = count;
+    LOG_WARN_EVERY(LOG_LIGHTS_LEFT_OUT, leftOut, "Warning: Only the first %d enabled lights are used", MAX_LIGHTS);
+
+    // Only the used prefix of the array has to go to the GPU
+    size_t bytes = offsetof(LightUniforms, lights) + count * sizeof(LightUniform);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubos.lightUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, bytes, &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+#endif
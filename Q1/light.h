@@ -1,10 +1,45 @@
+#ifndef LIGHT_H
+#define LIGHT_H
+
 #include "math_utils.h"
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
 
 struct Light {
     Vector3f position;
     Vector3f color;
     bool enabled;
     float intensity;
+    float radius;  // range of a point light; 0 lights everything without falloff
 };
 
-const int NUM_LIGHTS = 3;
\ No newline at end of file
+// Enabled lights beyond this are not uploaded. 256 lights of 32 bytes keep
+// the LightData block inside the 16 KB every GL 3.3 driver guarantees; keep
+// in sync with MAX_LIGHTS in shaders/shader.fs.
+const int MAX_LIGHTS = 256;
+
+// Scatters point lights of the given radius through a box, each with a random
+// fully saturated colour. They are dim so that overlapping ones do not wash out.
+void addRandomLights(std::vector<Light>& lights, int count, const Vector3f& minCorner, const Vector3f& maxCorner, float radius) {
+    for (int i = 0; i < count; i++) {
+        float tx = rand() / (float)RAND_MAX;
+        float ty = rand() / (float)RAND_MAX;
+        float tz = rand() / (float)RAND_MAX;
+        float hue = rand() / (float)RAND_MAX * 6.0f;
+
+        Light light;
+        light.position = Vector3f(minCorner.x + tx * (maxCorner.x - minCorner.x),
+                                  minCorner.y + ty * (maxCorner.y - minCorner.y),
+                                  minCorner.z + tz * (maxCorner.z - minCorner.z));
+        light.color = Vector3f(fminf(fmaxf(fabsf(hue - 3.0f) - 1.0f, 0.0f), 1.0f),
+                               fminf(fmaxf(2.0f - fabsf(hue - 2.0f), 0.0f), 1.0f),
+                               fminf(fmaxf(2.0f - fabsf(hue - 4.0f), 0.0f), 1.0f));
+        light.enabled = true;
+        light.intensity = 0.25f;
+        light.radius = radius;
+        lights.push_back(light);
+    }
+}
+
+#endif
@@ -15,10 +15,23 @@
 #include "math_utils.h"
 #include "OFFReader.h"
 #include "normal.h"
+#include "explosion.h"
 #include "camera.h"
 #include "light.h"
 #include "plane.h"
 #include "mesh_slicer.h"
+#include "slicer_gpu.h"
+#include "batch_slicer.h"
+#include "slice_worker.h"
+#include "slice_cache.h"
+#include "uniform_buffers.h"
+#include "profiler.h"
+#include "profiler_gl.h"
+#include "log_ui.h"
+#include "headless.h"
+#include "light_tiles.h"
+#include "program_cache.h"
+#include "picking.h"
 
 #define GL_SILENCE_DEPRECATION
 
@@ -33,8 +46,14 @@ std::vector<Plane> active_planes;
 MeshSlicerState g_slicerState;
 bool g_meshInitialized = false;
 bool meshSliced = false;
-GLuint slicedVAO = 0, slicedVBO = 0, slicedIBO = 0;
-int slicedVertexCount = 0;
+SlicedGPUBuffers slicedGPU;
+SliceWorker sliceWorker;
+double lastSliceMs = 0.0;
+SliceCache sliceCache;
+uint64_t pendingSliceKey = 0;
+int sliceCacheBudgetMB = DEFAULT_SLICE_CACHE_BUDGET >> 20;
+bool frustumCulling = true;
+PickState pickState;
 bool extremeExplosion = false;
 
 
@@ -57,9 +76,21 @@ bool isFullScreen = false;
 float rotation = 01.0f;
 GLuint VBO, VAO, IBO;
 GLuint ShaderProgram;
-GLuint gWorldLocation;
-GLuint gProjectionLocation; 
-GLuint gViewLocation;
+UniformBuffers uniformBuffers;
+Profiler g_profiler;
+TaskSystem g_tasks;
+LogState g_log;
+GpuTimer sceneGpuTimer;
+GpuTimer uiGpuTimer;
+bool showProfiler = true;
+
+// Redraw on demand: the loop sleeps in glfwWaitEventsTimeout until an input
+// event, a finished slice or auto-rotate asks for frames. A few frames are
+// drawn per request because ImGui needs them to settle hover and click state.
+const double IDLE_WAIT_SECONDS = 0.5;
+const int REDRAW_SETTLE_FRAMES = 3;
+int redrawFrames = REDRAW_SETTLE_FRAMES;
+bool continuousRedraw = false;
 
 Matrix4f ProjectionMatrix;
 Matrix4f viewMatrix; 
@@ -68,9 +99,17 @@ Vector3f cameraPos = Vector3f(0.0f, 0.0f, -25.0f);
 Vector3f cameraFront = Vector3f(0.0f, 0.0f, -1.0f);
 Vector3f cameraUp = Vector3f(0.0f, 1.0f, 0.0f);
 float cameraSpeed = 0.5f;
-GLuint viewPosLocation;
-GLuint lightPosLocation;
-Vector3f lightPos = Vector3f(5.0f, 5.0f, 5.0f);
+GLuint segmentExplosionLocation;
+GLuint segmentOffsetsLocation;
+GLuint regionPassLocation;
+GLuint tiledLightingLocation;
+GLuint lightTileSizeLocation;
+GLuint lightTilesXLocation;
+GLuint highlightedSegmentLocation;
+GLuint highlightedTriangleLocation;
+LightTiles lightTiles;
+bool tiledLighting = false;
+int selectedLight = 0;
 float yaw = -90.0f;   // Initialize to -90 so camera faces -Z direction
 float pitch = 0.0f;
 float rotationSpeed = 2.0f;
@@ -92,38 +131,66 @@ const GLFWvidmode* mode;
 const int ANIMATION_DELAY = 20; /* milliseconds between rendering */
 const char *pVSFileName = "shaders/shader.vs";
 const char *pFSFileName = "shaders/shader.fs";
-const char *pGSFileName = "shaders/shader.gs";
 
 
 std::vector<Light> lights = {
     // {{5.0f, 5.0f, 5.0f}, {0.0f, 1.0f, 0.0f}, true, 1.0f},  // Green light
     // {{-5.0f, 0.0f, 5.0f}, {1.0f, 0.0f, 0.0f}, true, 1.0f}, // Red light
     // {{0.0f, -5.0f, -5.0f}, {0.0f, 0.0f, 1.0f}, true, 1.0f} // Blue light
-    {{5.0f, 5.0f, 5.0f}, {1.0f, 1.0f, 1.0f}, true, 1.0f},  // Three whilte lights
-    {{-5.0f, 0.0f, 5.0f}, {1.0f, 1.0f, 1.0f}, false, 1.0f}, 
-    {{0.0f, -5.0f, -5.0f}, {1.0f, 1.0f, 1.0f}, false, 1.0f} 
+    {{5.0f, 5.0f, 5.0f}, {1.0f, 1.0f, 1.0f}, true, 1.0f, 0.0f},  // Three whilte lights
+    {{-5.0f, 0.0f, 5.0f}, {1.0f, 1.0f, 1.0f}, false, 1.0f, 0.0f}, 
+    {{0.0f, -5.0f, -5.0f}, {1.0f, 1.0f, 1.0f}, false, 1.0f, 0.0f} 
 };
 
 // Global OffModel pointer 
 OffModel* model = nullptr;
 
-void computeFPS()
+void requestRedraw()
+{
+    redrawFrames = REDRAW_SETTLE_FRAMES;
+}
+
+// Called once per loop iteration. Records the frame-to-frame time of frames
+// drawn back to back (a frame after an idle wait is not timed) and once a
+// second puts the FPS and the process CPU usage in the window title.
+void computeFPS(bool drawing)
 {
     static int frameCount = 0;
-    static int lastFrameTime = 0;
-    static char *title = NULL;
-    int currentTime;
-
-    if (!title)
-        title = (char *)malloc((strlen(theProgramTitle) + 20) * sizeof(char));
-    frameCount++;
-    currentTime = 0;
-    if (currentTime - lastFrameTime > 1000)
+    static double lastFrameTime = -1.0;
+    static double lastTitleTime = -1.0;
+    static double lastCpuSeconds = 0.0;
+    static char title[128];
+    double currentTime = profilerNowUs(g_profiler);
+
+    if (lastTitleTime < 0.0)
     {
-        sprintf(title, "%s [ FPS: %4.2f ]",
-                theProgramTitle,
-                frameCount * 1000.0 / (currentTime - lastFrameTime));
+        lastTitleTime = currentTime;
+        lastCpuSeconds = processCpuSeconds();
+    }
+
+    if (drawing)
+    {
+        if (lastFrameTime >= 0.0)
+            profileRecord(g_profiler, "Frame", lastFrameTime, currentTime - lastFrameTime);
         lastFrameTime = currentTime;
+        frameCount++;
+    }
+    else
+    {
+        lastFrameTime = -1.0;
+    }
+
+    if (currentTime - lastTitleTime > 1000000.0)
+    {
+        double cpuSeconds = processCpuSeconds();
+        double elapsed = (currentTime - lastTitleTime) / 1000000.0;
+        snprintf(title, sizeof(title), "%s [ FPS: %4.2f | CPU: %.1f%% ]",
+                theProgramTitle,
+                frameCount / elapsed,
+                100.0 * (cpuSeconds - lastCpuSeconds) / elapsed);
+        glfwSetWindowTitle(window, title);
+        lastTitleTime = currentTime;
+        lastCpuSeconds = cpuSeconds;
         frameCount = 0;
     }
 }
@@ -204,6 +271,8 @@ using namespace std;
 
 static void CompileShaders()
 {
+    PROFILE_SCOPE("Shaders");
+    double startUs = profilerNowUs(g_profiler);
     ShaderProgram = glCreateProgram();
 
     if (ShaderProgram == 0)
@@ -212,7 +281,7 @@ static void CompileShaders()
         exit(1);
     }
 
-    string vs, fs, gs;
+    string vs, fs;
 
     if (!ReadFile(pVSFileName, vs))
     {
@@ -224,26 +293,38 @@ static void CompileShaders()
         exit(1);
     }
 
-    if (!ReadFile(pGSFileName, gs))
-    {
-        exit;
-    }
-
-    AddShader(ShaderProgram, vs.c_str(), GL_VERTEX_SHADER);
-    AddShader(ShaderProgram, fs.c_str(), GL_FRAGMENT_SHADER);
-    AddShader(ShaderProgram, gs.c_str(), GL_GEOMETRY_SHADER);
-
     GLint Success = 0;
     GLchar ErrorLog[1024] = {0};
 
-    glLinkProgram(ShaderProgram);
-    glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &Success);
-    if (Success == 0)
+    // Try the binary from the last run before compiling from source
+    bool useCache = programBinarySupported();
+    uint64_t cacheKey = useCache ? programCacheKey({vs, fs}) : 0;
+    bool cached = useCache && loadProgramBinary(ShaderProgram, PROGRAM_CACHE_PATH, cacheKey);
+
+    if (!cached)
     {
-        glGetProgramInfoLog(ShaderProgram, sizeof(ErrorLog), NULL, ErrorLog);
-        fprintf(stderr, "Error linking shader program: '%s'\n", ErrorLog);
-        exit(1);
+        AddShader(ShaderProgram, vs.c_str(), GL_VERTEX_SHADER);
+        AddShader(ShaderProgram, fs.c_str(), GL_FRAGMENT_SHADER);
+        if (useCache)
+        {
+            glProgramParameteri(ShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        glLinkProgram(ShaderProgram);
+        glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &Success);
+        if (Success == 0)
+        {
+            glGetProgramInfoLog(ShaderProgram, sizeof(ErrorLog), NULL, ErrorLog);
+            fprintf(stderr, "Error linking shader program: '%s'\n", ErrorLog);
+            exit(1);
+        }
+        if (useCache)
+        {
+            saveProgramBinary(ShaderProgram, PROGRAM_CACHE_PATH, cacheKey);
+        }
     }
+    printf("Shader program %s in %.1f ms\n", cached ? "loaded from cache" : "compiled",
+           (profilerNowUs(g_profiler) - startUs) / 1000.0);
     glBindVertexArray(VAO);
     glValidateProgram(ShaderProgram);
     glGetProgramiv(ShaderProgram, GL_VALIDATE_STATUS, &Success);
@@ -255,34 +336,24 @@ static void CompileShaders()
     }
 
     glUseProgram(ShaderProgram);
-    gWorldLocation = glGetUniformLocation(ShaderProgram, "gWorld");
-    gViewLocation = glGetUniformLocation(ShaderProgram, "gView");  
-    gProjectionLocation = glGetUniformLocation(ShaderProgram, "gProjection");
-    viewPosLocation = glGetUniformLocation(ShaderProgram, "viewPos");
-    lightPosLocation = glGetUniformLocation(ShaderProgram, "lightPos");
-
-    for (int i = 0; i < NUM_LIGHTS; i++) {
-        std::string lightPosName = "lights[" + std::to_string(i) + "].position";
-        std::string lightColorName = "lights[" + std::to_string(i) + "].color";
-        std::string lightEnabledName = "lights[" + std::to_string(i) + "].enabled";
-        std::string lightIntensityName = "lights[" + std::to_string(i) + "].intensity";
-        
-        glUniform3f(glGetUniformLocation(ShaderProgram, lightPosName.c_str()), lights[i].position.x, lights[i].position.y, lights[i].position.z);
-        glUniform3f(glGetUniformLocation(ShaderProgram, lightColorName.c_str()), lights[i].color.x, lights[i].color.y, lights[i].color.z);
-        glUniform1i(glGetUniformLocation(ShaderProgram, lightEnabledName.c_str()), lights[i].enabled);
-        glUniform1f(glGetUniformLocation(ShaderProgram, lightIntensityName.c_str()), lights[i].intensity);
+    bindUniformBlocks(ShaderProgram);
+    segmentExplosionLocation = glGetUniformLocation(ShaderProgram, "segmentExplosionEnabled");
+    segmentOffsetsLocation = glGetUniformLocation(ShaderProgram, "segmentOffsets");
+    glUniform1i(segmentOffsetsLocation, 1);
+    regionPassLocation = glGetUniformLocation(ShaderProgram, "regionPassEnabled");
+    tiledLightingLocation = glGetUniformLocation(ShaderProgram, "tiledLighting");
+    lightTileSizeLocation = glGetUniformLocation(ShaderProgram, "lightTileSize");
+    lightTilesXLocation = glGetUniformLocation(ShaderProgram, "lightTilesX");
+    glUniform1i(glGetUniformLocation(ShaderProgram, "lightTiles"), 2);
+    glUniform1i(glGetUniformLocation(ShaderProgram, "lightIndices"), 3);
+    glUniform1i(lightTileSizeLocation, LIGHT_TILE_SIZE);
+    highlightedSegmentLocation = glGetUniformLocation(ShaderProgram, "highlightedSegment");
+    highlightedTriangleLocation = glGetUniformLocation(ShaderProgram, "highlightedTriangle");
+
+    if (uniformBuffers.frameUBO == 0) {
+        createUniformBuffers(uniformBuffers);
     }
-    GLint planeSlicingEnabledLoc = glGetUniformLocation(ShaderProgram, "planeSlicingEnabled");
-    
-    GLint plane1EnabledLoc = glGetUniformLocation(ShaderProgram, "plane1_enabled");
-    GLint plane2EnabledLoc = glGetUniformLocation(ShaderProgram, "plane2_enabled");
-    GLint plane3EnabledLoc = glGetUniformLocation(ShaderProgram, "plane3_enabled");
-    GLint plane4EnabledLoc = glGetUniformLocation(ShaderProgram, "plane4_enabled");
-    
-    GLint plane1EquationLoc = glGetUniformLocation(ShaderProgram, "plane1_equation");
-    GLint plane2EquationLoc = glGetUniformLocation(ShaderProgram, "plane2_equation");
-    GLint plane3EquationLoc = glGetUniformLocation(ShaderProgram, "plane3_equation");
-    GLint plane4EquationLoc = glGetUniformLocation(ShaderProgram, "plane4_equation");
+    uploadLightUniforms(uniformBuffers, lights);
 }
 
 GLuint debugShaderProgram = 0;
@@ -388,7 +459,10 @@ void updatePlaneBuffers(const std::vector<Plane>& planes, float size) {
 
  void onInit(int argc, char *argv[])
 {
-    model = readOffFile(argv[1]);
+    {
+        PROFILE_SCOPE("Load");
+        model = readOffFile(argv[1]);
+    }
     if (!model)
     {
         std::cerr << "Failed to load OFF file!" << std::endl;
@@ -404,9 +478,11 @@ void updatePlaneBuffers(const std::vector<Plane>& planes, float size) {
         );
     }
 
-    calculateVertexNormals(model);
-
-    faceNormals = calculateFaceNormals(model);
+    {
+        PROFILE_SCOPE("Normals");
+        calculateVertexNormals(model);
+        faceNormals = calculateFaceNormals(model);
+    }
     
     faceCenters = new Vector3f[model->numberOfPolygons];
     for(int i = 0; i < model->numberOfPolygons; i++) {
@@ -444,7 +520,10 @@ void updatePlaneBuffers(const std::vector<Plane>& planes, float size) {
     isExploded = false;
     extremeExplosion = false;
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-    CreateVertexBuffer();
+    {
+        PROFILE_SCOPE("Upload");
+        CreateVertexBuffer();
+    }
     CompileShaders();
 
     glEnable(GL_DEPTH_TEST);
@@ -562,46 +641,81 @@ static void onDisplay()
     Matrix4f World = viewMatrix * modelMatrix;
 
     glUseProgram(ShaderProgram);
-    glUniformMatrix4fv(gWorldLocation, 1, GL_TRUE, &modelMatrix.m[0][0]);
-    glUniformMatrix4fv(gViewLocation, 1, GL_TRUE, &viewMatrix.m[0][0]);    // Add this
-    glUniformMatrix4fv(gProjectionLocation, 1, GL_TRUE, &ProjectionMatrix.m[0][0]);
-    glUniform3f(viewPosLocation, cameraPos.x, cameraPos.y, cameraPos.z);
-    glUniform3f(lightPosLocation, lightPos.x, lightPos.y, lightPos.z);
 
     bool planeSlicingEnabled = !active_planes.empty() && !meshSliced ;
-    glUniform1i(glGetUniformLocation(ShaderProgram, "planeSlicingEnabled"), planeSlicingEnabled);
-    
-    glUniform1i(glGetUniformLocation(ShaderProgram, "plane1_enabled"), plane1.enabled);
-    glUniform4f(glGetUniformLocation(ShaderProgram, "plane1_equation"), 
-                plane1.a, plane1.b, plane1.c, plane1.d);
-    
-    glUniform1i(glGetUniformLocation(ShaderProgram, "plane2_enabled"), plane2.enabled);
-    glUniform4f(glGetUniformLocation(ShaderProgram, "plane2_equation"), 
-                plane2.a, plane2.b, plane2.c, plane2.d);
-    
-    glUniform1i(glGetUniformLocation(ShaderProgram, "plane3_enabled"), plane3.enabled);
-    glUniform4f(glGetUniformLocation(ShaderProgram, "plane3_equation"), 
-                plane3.a, plane3.b, plane3.c, plane3.d);
-    
-    glUniform1i(glGetUniformLocation(ShaderProgram, "plane4_enabled"), plane4.enabled);
-    glUniform4f(glGetUniformLocation(ShaderProgram, "plane4_equation"), 
-                plane4.a, plane4.b, plane4.c, plane4.d);
+    uniformBuffers.frame.planeSlicingEnabled = planeSlicingEnabled;
+    setFramePlane(uniformBuffers.frame, 0, plane1);
+    setFramePlane(uniformBuffers.frame, 1, plane2);
+    setFramePlane(uniformBuffers.frame, 2, plane3);
+    setFramePlane(uniformBuffers.frame, 3, plane4);
+    uploadFrameUniforms(uniformBuffers, modelMatrix, viewMatrix, ProjectionMatrix, cameraPos);
+
+    // Lights live in the space gWorld maps into, so they are projected with
+    // projection * view alone.
+    bool tiled = tiledLighting && uniformBuffers.lightData.lightCount > 0;
+    if (tiled) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        assignLightTiles(lightTiles, uniformBuffers.lightData, ProjectionMatrix * viewMatrix, viewport[2], viewport[3]);
+        uploadLightTiles(lightTiles);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_BUFFER, lightTiles.tileTexture);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_BUFFER, lightTiles.indexTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(lightTilesXLocation, lightTiles.tilesX);
+    }
+    glUniform1i(tiledLightingLocation, tiled);
+
+    // A pick only stays highlighted while the geometry it was made on is shown
+    bool segmentPicked = meshSliced && pickState.arena == g_slicerState.arena;
+    glUniform1i(highlightedSegmentLocation, segmentPicked ? pickState.pickedSegment : -1);
+    glUniform1i(highlightedTriangleLocation, meshSliced ? -1 : pickState.pickedTriangle);
 
 
     glBindVertexArray(VAO);
    
     if (meshSliced) {
-        glBindVertexArray(slicedVAO);
-        glDrawElements(GL_TRIANGLES, slicedVertexCount, GL_UNSIGNED_INT, 0);
+        glUniform1i(segmentExplosionLocation, GL_TRUE);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, slicedGPU.offsetTexture);
+        glActiveTexture(GL_TEXTURE0);
+        
+        Frustum frustum;
+        extractFrustum(ProjectionMatrix * viewMatrix * modelMatrix, frustum);
+        drawSlicedSegments(slicedGPU, frustumCulling ? &frustum : nullptr);
+        glUniform1i(segmentExplosionLocation, GL_FALSE);
     } else {
+        // Slicing preview: one instance per region, each clipped to its side
+        // of every enabled plane by the vertex shader's clip distances.
+        int regionCount = 1;
+        if (planeSlicingEnabled) {
+            const Plane* previewPlanes[4] = {&plane1, &plane2, &plane3, &plane4};
+            for (int i = 0; i < 4; i++) {
+                if (previewPlanes[i]->enabled) {
+                    regionCount *= 2;
+                    glEnable(GL_CLIP_DISTANCE0 + i);
+                }
+            }
+            glUniform1i(regionPassLocation, GL_TRUE);
+        }
+        
         if (explosionFactor > 0.0f) {
-            glDrawArrays(GL_TRIANGLES, 0, explodedVertexCount);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, explodedVertexCount, regionCount);
         } else {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-            glDrawElements(GL_TRIANGLES, model->numberOfPolygons * 3, GL_UNSIGNED_INT, 0);
+            glDrawElementsInstanced(GL_TRIANGLES, model->numberOfPolygons * 3, GL_UNSIGNED_INT, 0, regionCount);
+        }
+        
+        if (planeSlicingEnabled) {
+            glUniform1i(regionPassLocation, GL_FALSE);
+            for (int i = 0; i < 4; i++) {
+                glDisable(GL_CLIP_DISTANCE0 + i);
+            }
         }
     
         if (showPlanes && !active_planes.empty()) {
+            glUniform1i(highlightedTriangleLocation, -1);
             glEnable(GL_BLEND);
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
             
@@ -628,8 +742,35 @@ static void onDisplay()
     }
 }
 
+// Casts a ray through a point of the last drawn frame, in model space, and
+// picks the segment under it when the mesh is sliced, the triangle otherwise.
+void pickAt(float ndcX, float ndcY) {
+    PickRay ray;
+    if (!unprojectRay(ProjectionMatrix * viewMatrix * modelMatrix, ndcX, ndcY, ray)) {
+        return;
+    }
+
+    BVHHit hit;
+    if (meshSliced) {
+        pickState.pickedSegment = pickSegment(pickState, g_slicerState, ray, hit);
+    } else {
+        pickState.pickedTriangle = pickModelTriangle(pickState, model, explosionFactor, ray, hit);
+    }
+}
+
+void pickAtCursor(GLFWwindow* window) {
+    double x, y;
+    int width, height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    if (width > 0 && height > 0) {
+        pickAt(2.0f * (float)x / width - 1.0f, 1.0f - 2.0f * (float)y / height);
+    }
+}
+
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
     ImGui_ImplGlfw_MouseButtonCallback(window, button, action, mods);
+    requestRedraw();
     
     if (ImGui::GetIO().WantCaptureMouse) {
         return;
@@ -643,10 +784,15 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             isDragging = false;
         }
     }
+
+    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+        pickAtCursor(window);
+    }
 }
 
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
     ImGui_ImplGlfw_CursorPosCallback(window, xpos, ypos);
+    requestRedraw();
     if (ImGui::GetIO().WantCaptureMouse) {
         return;
     }
@@ -670,6 +816,7 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    requestRedraw();
     if (ImGui::GetIO().WantCaptureKeyboard) {
         return;
     }
@@ -744,6 +891,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
                     glViewport(0, 0, width, height);
                 }
                 break;
+            case GLFW_KEY_P: // Toggle profiler overlay
+                if (action == GLFW_PRESS) {
+                    showProfiler = !showProfiler;
+                }
+                break;
             case GLFW_KEY_ESCAPE:
                 glfwSetWindowShouldClose(window, true);
                 break;
@@ -758,11 +910,211 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     theWindowWidth = width;
     theWindowHeight = height;
     glViewport(0, 0, width, height);
+    requestRedraw();
 }
 
+// The remaining ImGui input callbacks, wrapped so they also wake the loop.
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    ImGui_ImplGlfw_ScrollCallback(window, xoffset, yoffset);
+    requestRedraw();
+}
+
+void char_callback(GLFWwindow* window, unsigned int c)
+{
+    ImGui_ImplGlfw_CharCallback(window, c);
+    requestRedraw();
+}
+
+void window_focus_callback(GLFWwindow* window, int focused)
+{
+    ImGui_ImplGlfw_WindowFocusCallback(window, focused);
+    requestRedraw();
+}
+
+void cursor_enter_callback(GLFWwindow* window, int entered)
+{
+    ImGui_ImplGlfw_CursorEnterCallback(window, entered);
+    requestRedraw();
+}
+
+void window_refresh_callback(GLFWwindow* window)
+{
+    requestRedraw();
+}
+
+// Renders a scripted orbit (one full turn with a dolly in and back out) into
+// an offscreen framebuffer and reports the time of every frame. Each frame is
+// finished with glFinish so the timings include the GPU work.
+int runHeadless(int argc, char *argv[])
+{
+    HeadlessOptions options;
+    if (!parseHeadlessOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Plane> planes;
+    if (options.planesPath && !readPlanesFile(options.planesPath, planes)) {
+        return 1;
+    }
+    if (!options.dumpDir.empty() && mkdir(options.dumpDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Could not create output directory %s\n", options.dumpDir.c_str());
+        return 1;
+    }
+
+    HeadlessContext headless;
+    if (!createHeadlessContext(headless, options.width, options.height)) {
+        destroyHeadlessContext(headless);
+        return 1;
+    }
+    theWindowWidth = options.width;
+    theWindowHeight = options.height;
+
+    char* initArgv[] = {argv[0], (char*)options.meshPath};
+    onInit(2, initArgv);
+
+    if (!planes.empty() && options.preview) {
+        Plane* previewPlanes[4] = {&plane1, &plane2, &plane3, &plane4};
+        for (size_t i = 0; i < planes.size() && i < 4; i++) {
+            *previewPlanes[i] = planes[i];
+        }
+        updateActivePlanes(plane1, plane2, plane3, plane4, active_planes);
+    } else if (!planes.empty()) {
+        double sliceStart = profilerNowUs(g_profiler);
+        sliceWithPlanes(g_slicerState, planes);
+        lastSliceMs = (profilerNowUs(g_profiler) - sliceStart) / 1000.0;
+        uploadToGPU(slicedGPU);
+        meshSliced = true;
+        printf("Sliced into %zu segments in %.2f ms, uploaded in %.2f ms\n",
+               getSegmentCount(), lastSliceMs, slicedGPU.lastUploadMs);
+    }
+
+    frustumCulling = options.culling;
+    tiledLighting = options.tiledLighting;
+    if (options.lights > 0) {
+        Vector3f margin = Vector3f(1.0f, 1.0f, 1.0f) * (model->extent * 0.1f);
+        addRandomLights(lights, options.lights, Vector3f(model->minX, model->minY, model->minZ) - margin,
+                        Vector3f(model->maxX, model->maxY, model->maxZ) + margin, model->extent * 0.2f);
+        uploadLightUniforms(uniformBuffers, lights);
+        printf("%d lights in use%s\n", uniformBuffers.lightData.lightCount, tiledLighting ? ", tiled" : "");
+    }
+    explosionFactor = options.explosion;
+    if (meshSliced) {
+        updateSlicedMeshExplosion(explosionFactor, model);
+        uploadSegmentOffsets(slicedGPU);
+    } else if (explosionFactor > 0.0f) {
+        glBindVertexArray(VAO);
+        updateMeshExplosion(model, explosionFactor, originalVertices, faceNormals, faceCenters, VBO, explodedVertexCount);
+        glBindVertexArray(0);
+    }
+
+    FILE* csv = nullptr;
+    if (options.csvPath) {
+        csv = fopen(options.csvPath, "w");
+        if (!csv) {
+            fprintf(stderr, "Error: Could not write %s\n", options.csvPath);
+        } else {
+            fprintf(csv, "frame,submit_ms,frame_ms,gpu_ms\n");
+        }
+    }
+
+    GLuint gpuQuery = 0;
+    bool gpuTimed = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (gpuTimed) {
+        glGenQueries(1, &gpuQuery);
+    }
+
+    // Warm up once so shader compilation and first-use allocations stay out
+    // of the numbers.
+    onDisplay();
+    glFinish();
+
+    Vector3f startPos = cameraPos;
+    std::vector<float> frameTimes;
+    std::vector<float> gpuTimes;
+    size_t drawnSegments = 0;
+    double totalStart = profilerNowUs(g_profiler);
+    for (int frame = 0; frame < options.frames; frame++) {
+        float t = (float)frame / options.frames;
+        rotationY = 2.0f * M_PI * t;
+        rotationX = 0.4f * sinf(2.0f * M_PI * t);
+        cameraPos = startPos * (1.0f - 0.5f * sinf(M_PI * t));
+
+        double frameStart = profilerNowUs(g_profiler);
+        if (gpuTimed) {
+            glBeginQuery(GL_TIME_ELAPSED, gpuQuery);
+        }
+        onDisplay();
+        if (gpuTimed) {
+            glEndQuery(GL_TIME_ELAPSED);
+        }
+        double submitUs = profilerNowUs(g_profiler) - frameStart;
+        glFinish();
+        double frameUs = profilerNowUs(g_profiler) - frameStart;
+
+        double gpuMs = 0.0;
+        if (gpuTimed) {
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(gpuQuery, GL_QUERY_RESULT, &elapsedNs);
+            gpuMs = elapsedNs / 1000000.0;
+            gpuTimes.push_back((float)gpuMs);
+        }
+        frameTimes.push_back((float)(frameUs / 1000.0));
+        drawnSegments += meshSliced ? slicedGPU.lastDrawnSegments : 0;
+
+        if (csv) {
+            fprintf(csv, "%d,%.4f,%.4f,%.4f\n", frame, submitUs / 1000.0, frameUs / 1000.0, gpuMs);
+        }
+        if (!options.dumpDir.empty() && frame % options.dumpEvery == 0) {
+            char path[64];
+            snprintf(path, sizeof(path), "/frame_%05d.ppm", frame);
+            writeFramePPM((options.dumpDir + path).c_str(), options.width, options.height);
+        }
+    }
+    double totalMs = (profilerNowUs(g_profiler) - totalStart) / 1000.0;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    std::sort(gpuTimes.begin(), gpuTimes.end());
+    printf("%d frames at %dx%d in %.1f ms (%.1f FPS)\n", options.frames, options.width, options.height,
+           totalMs, options.frames * 1000.0 / totalMs);
+    printf("frame ms: p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n", historyPercentile(frameTimes, 0.50f),
+           historyPercentile(frameTimes, 0.95f), historyPercentile(frameTimes, 0.99f), frameTimes.back());
+    if (meshSliced) {
+        printf("segments drawn per frame: %.1f of %zu\n", (double)drawnSegments / options.frames, getSegmentCount());
+    }
+    if (gpuTimed) {
+        printf("gpu ms:   p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n", historyPercentile(gpuTimes, 0.50f),
+               historyPercentile(gpuTimes, 0.95f), historyPercentile(gpuTimes, 0.99f), gpuTimes.back());
+    }
+
+    GLenum errorCode = glGetError();
+    if (csv) {
+        fclose(csv);
+    }
+    if (gpuTimed) {
+        glDeleteQueries(1, &gpuQuery);
+    }
+    FreeOffModel(model);
+    cleanupMeshSlicer();
+    destroySlicedBuffers(slicedGPU);
+    destroyUniformBuffers(uniformBuffers);
+    destroyLightTiles(lightTiles);
+    delete[] faceNormals;
+    delete[] faceCenters;
+    destroyHeadlessContext(headless);
+    return errorCode == GL_NO_ERROR ? 0 : 1;
+}
 
 int main(int argc, char *argv[])
 {
+    if (isBatchSliceCommand(argc, argv)) {
+        return runBatchSlicing(argc, argv);
+    }
+    startTaskSystem(g_tasks);
+    if (isHeadlessCommand(argc, argv)) {
+        return runHeadless(argc, argv);
+    }
+
     if (argc > 1) {
         model_name = argv[1];
 
@@ -805,10 +1157,49 @@ int main(int argc, char *argv[])
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_position_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetCharCallback(window, char_callback);
+    glfwSetWindowFocusCallback(window, window_focus_callback);
+    glfwSetCursorEnterCallback(window, cursor_enter_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+
+    createGpuTimer(sceneGpuTimer, "GPU scene");
+    createGpuTimer(uiGpuTimer, "GPU UI");
+    sliceWorker.notify = glfwPostEmptyEvent;
+    startSliceWorker(sliceWorker);
 
     while (!glfwWindowShouldClose(window))
     {
+        if (continuousRedraw || autoRotate || redrawFrames > 0) {
+            glfwPollEvents();
+        } else {
+            glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+        }
+
+        if (pollSliceResult(sliceWorker, g_slicerState, &lastSliceMs)) {
+            requestRedraw();
+            insertSliceCache(sliceCache, pendingSliceKey, g_slicerState);
+            {
+                PROFILE_SCOPE("Upload");
+                uploadToGPU(slicedGPU);
+                updateSlicedMeshExplosion(explosionFactor, model);
+                uploadSegmentOffsets(slicedGPU);
+            }
+            meshSliced = true;
+            
+            printf("Mesh sliced into %zu segments in %.2f ms\n", getSegmentCount(), lastSliceMs);
+        }
+
+        bool drawing = continuousRedraw || autoRotate || redrawFrames > 0;
+        computeFPS(drawing);
+        if (!drawing) {
+            continue;
+        }
+        if (redrawFrames > 0) {
+            redrawFrames--;
+        }
 
+        double uiStart = profilerNowUs(g_profiler);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -825,37 +1216,68 @@ int main(int argc, char *argv[])
         ImGui::SetNextWindowSize(ImVec2(UI_PANEL_WIDTH, 0), ImGuiCond_Always);
         ImGui::Begin("Light Controls", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
         
-        glUseProgram(ShaderProgram); 
-        glUniform3f(viewPosLocation, cameraPos.x, cameraPos.y, cameraPos.z);
+        bool lightsChanged = false;
+        ImGui::Text("%zu lights, %d in use", lights.size(), uniformBuffers.lightData.lightCount);
+        if (ImGui::Button("Add")) {
+            Vector3f position((model->minX + model->maxX) / 2.0f, (model->minY + model->maxY) / 2.0f,
+                              model->maxZ + model->extent * 0.5f);
+            lights.push_back({position, {1.0f, 1.0f, 1.0f}, true, 1.0f, model->extent * 0.5f});
+            selectedLight = lights.size() - 1;
+            lightsChanged = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Add 50 random")) {
+            Vector3f margin = Vector3f(1.0f, 1.0f, 1.0f) * (model->extent * 0.1f);
+            addRandomLights(lights, 50, Vector3f(model->minX, model->minY, model->minZ) - margin,
+                            Vector3f(model->maxX, model->maxY, model->maxZ) + margin, model->extent * 0.2f);
+            lightsChanged = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Remove") && !lights.empty()) {
+            lights.erase(lights.begin() + selectedLight);
+            lightsChanged = true;
+        }
+        selectedLight = std::max(0, std::min(selectedLight, (int)lights.size() - 1));
         
-        for (int i = 0; i < NUM_LIGHTS; i++) {
-            ImGui::PushID(i);
-            std::string label = "Light " + std::to_string(i + 1);
-            
-            if (ImGui::CollapsingHeader(label.c_str())) {
-                bool changed = false;
-                changed |= ImGui::Checkbox("Enabled", &lights[i].enabled);
-                changed |= ImGui::ColorEdit3("Color", &lights[i].color.x);
-                changed |= ImGui::SliderFloat("Intensity", &lights[i].intensity, 0.0f, 2.0f);
-                changed |= ImGui::SliderFloat3("Position", &lights[i].position.x, -10.0f, 10.0f);
-                
-                if (changed) {
-                    std::string lightPosName = "lights[" + std::to_string(i) + "].position";
-                    std::string lightColorName = "lights[" + std::to_string(i) + "].color";
-                    std::string lightEnabledName = "lights[" + std::to_string(i) + "].enabled";
-                    std::string lightIntensityName = "lights[" + std::to_string(i) + "].intensity";
-                    
-                    glUniform3f(glGetUniformLocation(ShaderProgram, lightPosName.c_str()), 
-                                lights[i].position.x, lights[i].position.y, lights[i].position.z);
-                    glUniform3f(glGetUniformLocation(ShaderProgram, lightColorName.c_str()), 
-                                lights[i].color.x, lights[i].color.y, lights[i].color.z);
-                    glUniform1i(glGetUniformLocation(ShaderProgram, lightEnabledName.c_str()), 
-                                lights[i].enabled);
-                    glUniform1f(glGetUniformLocation(ShaderProgram, lightIntensityName.c_str()), 
-                                lights[i].intensity);
+        // Only the visible rows of the list are submitted, however many lights there are
+        ImGui::BeginChild("LightList", ImVec2(0, 90), ImGuiChildFlags_Borders);
+        ImGuiListClipper clipper;
+        clipper.Begin(lights.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                ImGui::PushID(i);
+                lightsChanged |= ImGui::Checkbox("##enabled", &lights[i].enabled);
+                ImGui::SameLine();
+                ImGui::ColorButton("##color", ImVec4(lights[i].color.x, lights[i].color.y, lights[i].color.z, 1.0f),
+                                   ImGuiColorEditFlags_NoTooltip, ImVec2(ImGui::GetFrameHeight(), ImGui::GetFrameHeight()));
+                ImGui::SameLine();
+                std::string label = "Light " + std::to_string(i + 1);
+                if (ImGui::Selectable(label.c_str(), selectedLight == i)) {
+                    selectedLight = i;
                 }
+                ImGui::PopID();
             }
-            ImGui::PopID();
+        }
+        ImGui::EndChild();
+        
+        if (!lights.empty()) {
+            Light& light = lights[selectedLight];
+            lightsChanged |= ImGui::ColorEdit3("Color", &light.color.x);
+            lightsChanged |= ImGui::SliderFloat("Intensity", &light.intensity, 0.0f, 2.0f);
+            // Up to one extent past the model on every side
+            float positionMin = std::min(std::min(model->minX, model->minY), model->minZ) - model->extent;
+            float positionMax = std::max(std::max(model->maxX, model->maxY), model->maxZ) + model->extent;
+            lightsChanged |= ImGui::SliderFloat3("Position", &light.position.x, positionMin, positionMax);
+            lightsChanged |= ImGui::SliderFloat("Radius", &light.radius, 0.0f, model->extent);
+        }
+        
+        ImGui::Checkbox("Tiled light culling", &tiledLighting);
+        if (tiledLighting) {
+            ImGui::Text("%.1f lights/tile, assigned in %.2f ms", lightTiles.averageLightsPerTile, lightTiles.lastAssignMs);
+        }
+        
+        if (lightsChanged) {
+            uploadLightUniforms(uniformBuffers, lights);
         }
         
         ImGui::End();
@@ -959,7 +1381,7 @@ int main(int argc, char *argv[])
         ImGui::PopID();
 
         if (plane1Changed || plane2Changed || plane3Changed || plane4Changed) {
-            printf("Changing plane data\n");
+            LOG_DEBUG("Changing plane data\n");
             updateActivePlanes(plane1, plane2, plane3, plane4, active_planes);
             updatePlaneBuffers(active_planes, planeSize);
         }
@@ -976,7 +1398,10 @@ int main(int argc, char *argv[])
             isExploded = !isExploded;
             explosionFactor = isExploded ? 2.0f : 0.0f;
             
-            if (!isExploded) {
+            if (meshSliced) {
+                updateSlicedMeshExplosion(explosionFactor, model);
+                uploadSegmentOffsets(slicedGPU);
+            } else if (!isExploded) {
                 glBindBuffer(GL_ARRAY_BUFFER, VBO);
                 glBufferData(GL_ARRAY_BUFFER, model->numberOfVertices * sizeof(Vertex), 
                             model->vertices, GL_STATIC_DRAW);
@@ -989,17 +1414,10 @@ int main(int argc, char *argv[])
         }
 
         if (meshSliced) {
-            glUseProgram(ShaderProgram);
-            glUniformMatrix4fv(gWorldLocation, 1, GL_TRUE, &modelMatrix.m[0][0]);
-            glUniformMatrix4fv(gViewLocation, 1, GL_TRUE, &viewMatrix.m[0][0]);
-            glUniformMatrix4fv(gProjectionLocation, 1, GL_TRUE, &ProjectionMatrix.m[0][0]);
-            
-            glUniform3f(viewPosLocation, cameraPos.x, cameraPos.y, cameraPos.z);
-            
-           
-            
-            glBindVertexArray(VAO);
-            glDrawElements(GL_TRIANGLES, model->numberOfPolygons * 3, GL_UNSIGNED_INT, 0);
+            if (ImGui::SliderFloat("Explosion Factor", &explosionFactor, 0.0f, 2.0f)) {
+                updateSlicedMeshExplosion(explosionFactor, model);
+                uploadSegmentOffsets(slicedGPU);
+            }
         } else {
             if (ImGui::SliderFloat("Explosion Factor", &explosionFactor, 0.0f, 2.0f)) {
                 glBindVertexArray(VAO);
@@ -1017,19 +1435,56 @@ int main(int argc, char *argv[])
         ImGui::Begin("Mesh Slicing Controls", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
 
         if (ImGui::Button("Slice Mesh")) {
-            sliceWithPlanes(active_planes);
-            uploadToGPU(slicedVAO, slicedVBO, slicedIBO, slicedVertexCount);
-            meshSliced = true;
-            
-            printf("Mesh sliced into %zu segments with different colors\n", getSegmentCount());
+            uint64_t key = sliceCacheKey(model, active_planes);
+            if (lookupSliceCache(sliceCache, key, g_slicerState)) {
+                cancelSlice(sliceWorker);
+                PROFILE_SCOPE("Upload");
+                if (!adoptRetainedBuffers(slicedGPU)) {
+                    uploadToGPU(slicedGPU);
+                }
+                updateSlicedMeshExplosion(explosionFactor, model);
+                uploadSegmentOffsets(slicedGPU);
+                meshSliced = true;
+                printf("Slice cache hit: %zu segments\n", getSegmentCount());
+            } else {
+                pendingSliceKey = key;
+                requestSlice(sliceWorker, model, active_planes);
+            }
         }
 
         if (ImGui::Button("Reset Mesh")) {
+            cancelSlice(sliceWorker);
             meshSliced = false;
         }
 
+        if (sliceWorker.busy) {
+            ImGui::SameLine();
+            ImGui::Text("Slicing...");
+        }
+
         ImGui::Text("Active planes: %zu", active_planes.size());
         ImGui::Text("Mesh segments: %zu", meshSliced ? getSegments().size() : 0);
+        ImGui::Checkbox("Frustum culling", &frustumCulling);
+        ImGui::SameLine();
+        ImGui::Text("drawn %zu", meshSliced ? slicedGPU.lastDrawnSegments : 0);
+        if (meshSliced) {
+            ImGui::Text("Right-click to pick: segment %d", pickState.pickedSegment);
+        } else {
+            ImGui::Text("Right-click to pick: triangle %d", pickState.pickedTriangle);
+        }
+        ImGui::Text("Last pick: %.3f ms (BVH build %.1f ms)", pickState.lastPickMs, pickState.lastBuildMs);
+        ImGui::Text("Last slice: %.2f ms", lastSliceMs);
+        ImGui::Text("Last upload: %.2f ms (%zu segments)", slicedGPU.lastUploadMs, slicedGPU.lastUploadedSegments);
+        ImGui::Text("Slice cache: %zu entries, %.1f MB, %zu hits / %zu misses", sliceCache.entries.size(),
+                    sliceCache.usedBytes / (1024.0 * 1024.0), sliceCache.hits, sliceCache.misses);
+        if (ImGui::SliderInt("Cache budget (MB)", &sliceCacheBudgetMB, 0, 2048)) {
+            setSliceCacheBudget(sliceCache, (size_t)sliceCacheBudgetMB << 20);
+        }
+        ImGui::Text("GPU buffers: %zu/%zu vertices%s", slicedGPU.vertexUsed, slicedGPU.vertexCapacity,
+                    slicedGPU.persistent ? " (mapped)" : "");
+        if (ImGui::CollapsingHeader("Log")) {
+            drawLogPanel(g_log);
+        }
 
         ImGui::End();
 
@@ -1040,6 +1495,7 @@ int main(int argc, char *argv[])
             ImGui::Begin("Rotation Controls", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
             ImGui::Checkbox("Auto Rotate", &autoRotate);
             ImGui::SliderFloat("Rotation Speed", &rotationSpeed, -2.0f, 2.0f);
+            ImGui::Checkbox("Redraw every frame", &continuousRedraw);
             if(ImGui::Button("Reset Rotation")) {
                 rotation = 0.0f;
                 rotationX = 0.0f;
@@ -1055,23 +1511,48 @@ int main(int argc, char *argv[])
         
         }
 
-        onDisplay();
+        if (showProfiler) {
+            ImGui::SetNextWindowPos(ImVec2(theWindowWidth - 380, 120), ImGuiCond_FirstUseEver);
+            drawProfilerOverlay(g_profiler, g_tasks, "Frame", &showProfiler);
+        }
+        profileRecord(g_profiler, "UI build", uiStart, profilerNowUs(g_profiler) - uiStart);
+
+        {
+            PROFILE_SCOPE("Draw");
+            bool timed = beginGpuTimer(sceneGpuTimer);
+            onDisplay();
+            if (timed) {
+                endGpuTimer(sceneGpuTimer);
+            }
+        }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            PROFILE_SCOPE("UI draw");
+            ImGui::Render();
+            bool timed = beginGpuTimer(uiGpuTimer);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            if (timed) {
+                endGpuTimer(uiGpuTimer);
+            }
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("Swap");
+            glfwSwapBuffers(window);
+        }
     }
 
+    stopSliceWorker(sliceWorker);
+    stopTaskSystem(g_tasks);
+    clearSliceCache(sliceCache);
     FreeOffModel(model);
 
     cleanupMeshSlicer();
-    if (slicedVAO != 0) {
-        glDeleteVertexArrays(1, &slicedVAO);
-        glDeleteBuffers(1, &slicedVBO);
-        glDeleteBuffers(1, &slicedIBO);
-    }
+    destroySlicedBuffers(slicedGPU);
+    destroyUniformBuffers(uniformBuffers);
+    destroyGpuTimer(sceneGpuTimer);
+    destroyGpuTimer(uiGpuTimer);
+    destroyLightTiles(lightTiles);
     if (planeVAO != 0) {
         glDeleteVertexArrays(1, &planeVAO);
         glDeleteBuffers(1, &planeVBO);
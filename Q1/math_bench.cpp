@@ -0,0 +1,198 @@
+// Microbenchmarks for math_utils.h. Times each SIMD path against its scalar
+// version on the same random inputs, checks that they agree, and prints one
+// row per operation. Build with -DMATH_NO_SIMD to see the fallback timings.
+//
+//   ./math_bench [-n count] [-r repeat]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include "math_utils.h"
+#include "task_system.h"
+
+TaskSystem g_tasks;
+
+typedef std::chrono::high_resolution_clock BenchClock;
+
+double elapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+// Keeps results alive so the timed loops are not optimized away.
+volatile float g_sink;
+
+struct BenchInputs {
+    std::vector<Matrix4f> matrices;
+    std::vector<Vector4f> vectors;
+    std::vector<Vector3f> points;
+};
+
+void fillInputs(BenchInputs& inputs, size_t count) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    inputs.matrices.resize(count);
+    for (Matrix4f& m : inputs.matrices) {
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                m.m[i][j] = value(rng);
+            }
+        }
+    }
+    inputs.vectors.resize(count);
+    for (Vector4f& v : inputs.vectors) {
+        v = Vector4f(value(rng), value(rng), value(rng), value(rng));
+    }
+    inputs.points.resize(count);
+    for (Vector3f& p : inputs.points) {
+        p = Vector3f(value(rng), value(rng), value(rng));
+    }
+}
+
+float maxDifference(const float* a, const float* b, size_t count) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        worst = std::max(worst, fabsf(a[i] - b[i]));
+    }
+    return worst;
+}
+
+// Best of repeat runs, in nanoseconds per element.
+template <typename F>
+double timeNs(F run, size_t count, int repeat) {
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = BenchClock::now();
+        run();
+        best = std::min(best, elapsedMs(start));
+    }
+    return best * 1e6 / count;
+}
+
+void printRow(const char* name, double scalarNs, double simdNs, float error) {
+    printf("%-20s %10.2f %10.2f %8.2fx %12.3g\n", name, scalarNs, simdNs, scalarNs / simdNs, error);
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = 1 << 20;
+    int repeat = 5;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            count = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: %s [-n count] [-r repeat]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    startTaskSystem(g_tasks);
+    BenchInputs inputs;
+    fillInputs(inputs, count);
+    printf("%zu elements, best of %d, SIMD %s\n", count, repeat, MATH_SIMD ? "on" : "off");
+    printf("%-20s %10s %10s %9s %12s\n", "op", "scalar ns", "simd ns", "speedup", "max error");
+
+    // Matrix products, each matrix times its neighbour
+    {
+        std::vector<Matrix4f> scalar(count), simd(count);
+        double scalarNs = timeNs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                scalar[i] = inputs.matrices[i].MultiplyScalar(inputs.matrices[(i + 1) % count]);
+            }
+            g_sink = scalar[count / 2].m[1][2];
+        }, count, repeat);
+        double simdNs = timeNs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                simd[i] = inputs.matrices[i] * inputs.matrices[(i + 1) % count];
+            }
+            g_sink = simd[count / 2].m[1][2];
+        }, count, repeat);
+        printRow("mat4 * mat4", scalarNs, simdNs, maxDifference(&scalar[0].m[0][0], &simd[0].m[0][0], count * 16));
+    }
+
+    // Batch point transform
+    {
+        const Matrix4f& m = inputs.matrices[1];
+        std::vector<Vector3f> scalar(count), simd(count);
+        double scalarNs = timeNs([&]() {
+            transformPointsScalar(m, inputs.points.data(), scalar.data(), count);
+            g_sink = scalar[count / 2].x;
+        }, count, repeat);
+        double simdNs = timeNs([&]() {
+            transformPoints(m, inputs.points.data(), simd.data(), count);
+            g_sink = simd[count / 2].x;
+        }, count, repeat);
+        printRow("transformPoints", scalarNs, simdNs, maxDifference(&scalar[0].x, &simd[0].x, count * 3));
+    }
+
+    // Batch transform from separate x, y, z arrays, with the w row
+    {
+        const Matrix4f& m = inputs.matrices[2];
+        std::vector<float> x(count), y(count), z(count);
+        for (size_t i = 0; i < count; i++) {
+            x[i] = inputs.points[i].x;
+            y[i] = inputs.points[i].y;
+            z[i] = inputs.points[i].z;
+        }
+        std::vector<float> scalar(count * 4), simd(count * 4), parallel(count * 4);
+        TransformSoA scalarSoA = {x.data(), y.data(), z.data(), &scalar[0], &scalar[count], &scalar[2 * count], &scalar[3 * count]};
+        TransformSoA simdSoA = {x.data(), y.data(), z.data(), &simd[0], &simd[count], &simd[2 * count], &simd[3 * count]};
+        TransformSoA parallelSoA = {x.data(), y.data(), z.data(), &parallel[0], &parallel[count], &parallel[2 * count], &parallel[3 * count]};
+
+        double scalarNs = timeNs([&]() {
+            transformPointsSoAScalar(m, scalarSoA, 0, count);
+            g_sink = scalar[count / 2];
+        }, count, repeat);
+        double simdNs = timeNs([&]() {
+            transformPointsSoA(m, simdSoA, 0, count);
+            g_sink = simd[count / 2];
+        }, count, repeat);
+        double parallelNs = timeNs([&]() {
+            parallelFor(g_tasks, 0, count, taskGrain(g_tasks, count, 1 << 16), [&](size_t begin, size_t end) {
+                transformPointsSoA(m, parallelSoA, begin, end);
+            });
+            g_sink = parallel[count / 2];
+        }, count, repeat);
+        printRow("transformPointsSoA", scalarNs, simdNs, maxDifference(scalar.data(), simd.data(), count * 4));
+        printRow("  parallel", scalarNs, parallelNs, maxDifference(scalar.data(), parallel.data(), count * 4));
+    }
+
+    // No separate SIMD path for these; listed for reference
+    {
+        const Matrix4f& m = inputs.matrices[0];
+        std::vector<Vector4f> transformed(count);
+        double transformNs = timeNs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                transformed[i] = m * inputs.vectors[i];
+            }
+            g_sink = transformed[count / 2].x;
+        }, count, repeat);
+
+        std::vector<Vector3f> out(count);
+        double normalizeNs = timeNs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = inputs.points[i];
+                out[i].Normalize();
+            }
+            g_sink = out[count / 2].x;
+        }, count, repeat);
+        double crossNs = timeNs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = inputs.points[i].Cross(inputs.points[(i + 1) % count]) + inputs.points[i];
+            }
+            g_sink = out[count / 2].x;
+        }, count, repeat);
+        printf("%-20s %10.2f\n", "mat4 * vec4", transformNs);
+        printf("%-20s %10.2f\n", "vec3 Normalize", normalizeNs);
+        printf("%-20s %10.2f\n", "vec3 Cross + add", crossNs);
+    }
+
+    return 0;
+}
@@ -2,23 +2,86 @@
 
 struct Light {
     vec3 position;
+    float radius;     // 0: no falloff
     vec3 color;
-    bool enabled;
     float intensity;
 };
 
-const int NUM_LIGHTS = 3;
-uniform Light lights[NUM_LIGHTS];
-uniform vec3 viewPos;
-uniform bool planeSlicingEnabled;
+// Enabled lights only, packed (see include/uniform_buffers.h). Keep
+// MAX_LIGHTS in sync with light.h.
+const int MAX_LIGHTS = 256;
+layout(std140) uniform LightData {
+    int lightCount;
+    Light lights[MAX_LIGHTS];
+};
+
+// Tiled light lists (see include/light_tiles.h): per screen tile an
+// (offset, count) into lightIndices
+uniform bool tiledLighting;
+uniform int lightTileSize;
+uniform int lightTilesX;
+uniform usamplerBuffer lightTiles;
+uniform usamplerBuffer lightIndices;
+
+layout(std140) uniform FrameData {
+    layout(row_major) mat4 gWorld;
+    layout(row_major) mat4 gView;
+    layout(row_major) mat4 gProjection;
+    vec3 viewPos;
+    vec4 plane1_equation; // (a, b, c, d) where ax + by + cz + d = 0
+    vec4 plane2_equation;
+    vec4 plane3_equation;
+    vec4 plane4_equation;
+    bool plane1_enabled;
+    bool plane2_enabled;
+    bool plane3_enabled;
+    bool plane4_enabled;
+    bool planeSlicingEnabled;
+};
 
 in vec3 FragPos;
 in vec3 Normal_vs;
+in vec3 WorldPos;
+in vec3 WorldNormal;
 in vec3 Color_vs;
 in float Depth;
+in vec4 PlaneDistance;
+flat in int Highlighted;
+
+// Model triangle picked with the mouse, -1 for none
+uniform int highlightedTriangle;
+
+uniform bool regionPassEnabled;
+
+vec3 highlightColor = vec3(1.0, 1.0, 1.0); // White highlight
+float highlightIntensity = 0.5;
 
 out vec4 FragColor;
 
+// Diffuse plus a little Blinn-Phong specular, with a smooth window that
+// reaches zero at the light's radius
+vec3 shadeLight(Light light, vec3 normal, vec3 viewDir) {
+    vec3 toLight = light.position - WorldPos;
+    float distanceSquared = dot(toLight, toLight);
+    float attenuation = 1.0;
+    if (light.radius > 0.0) {
+        float radiusSquared = light.radius * light.radius;
+        if (distanceSquared >= radiusSquared) {
+            return vec3(0.0);
+        }
+        float falloff = 1.0 - distanceSquared / radiusSquared;
+        attenuation = falloff * falloff;
+    }
+
+    vec3 lightDir = toLight * inversesqrt(max(distanceSquared, 1e-8));
+    float diff = dot(normal, lightDir);
+    if (diff <= 0.0) {
+        return vec3(0.0);
+    }
+    float spec = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), 32.0);
+    return (diff + 0.3 * spec) * light.color * (light.intensity * attenuation);
+}
+
 void main() {
     vec3 baseColor = Color_vs;
     
@@ -26,16 +89,40 @@ void main() {
         baseColor = mix(baseColor, vec3(0.8, 0.4, 0.8), 0.2);
     }
     
-    vec3 normal = normalize(Normal_vs);
+    // Highlight the cut along each plane, about a pixel wide
+    if (regionPassEnabled) {
+        vec4 edge = abs(PlaneDistance) / max(fwidth(PlaneDistance), vec4(1e-6));
+        float nearest = min(min(edge.x, edge.y), min(edge.z, edge.w));
+        baseColor = mix(baseColor, highlightColor, highlightIntensity * (1.0 - smoothstep(0.5, 1.5, nearest)));
+    }
+    
+    vec3 normal = normalize(WorldNormal);
+    vec3 viewDir = normalize(viewPos - WorldPos);
+    // Meshes are drawn without culling; light the side that faces the eye
+    if (dot(normal, viewDir) < 0.0) {
+        normal = -normal;
+    }
     
-    float ambientStrength = 0.5;
-    vec3 ambient = ambientStrength * baseColor;
+    float ambientStrength = 0.3;
+    vec3 lighting = vec3(0.0);
     
-    vec3 lightDir = normalize(vec3(0.0, 1.0, 0.0));
-    float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = diff * baseColor * 0.5;
+    if (tiledLighting) {
+        ivec2 tile = ivec2(gl_FragCoord.xy) / lightTileSize;
+        uvec2 range = texelFetch(lightTiles, tile.y * lightTilesX + tile.x).xy;
+        for (uint k = 0u; k < range.y; k++) {
+            int i = int(texelFetch(lightIndices, int(range.x + k)).r);
+            lighting += shadeLight(lights[i], normal, viewDir);
+        }
+    } else {
+        for (int i = 0; i < lightCount; i++) {
+            lighting += shadeLight(lights[i], normal, viewDir);
+        }
+    }
     
-    vec3 result = ambient + diffuse;
+    vec3 result = baseColor * (ambientStrength + 0.7 * lighting);
+    if (Highlighted != 0 || gl_PrimitiveID == highlightedTriangle) {
+        result = mix(result, vec3(1.0, 0.9, 0.2), 0.5);
+    }
     
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -3,21 +3,108 @@
 layout(location = 0) in vec3 Position;
 layout(location = 1) in vec3 Color;
 layout(location = 2) in vec3 Normal;
+layout(location = 3) in int SegmentId;
 
-uniform mat4 gWorld;
-uniform mat4 gProjection;
-uniform mat4 gView;  
-uniform vec3 viewPos;
+// Per-frame state, shared with the fragment shader (see include/uniform_buffers.h).
+// Up to 4 preview planes.
+layout(std140) uniform FrameData {
+    layout(row_major) mat4 gWorld;
+    layout(row_major) mat4 gView;
+    layout(row_major) mat4 gProjection;
+    vec3 viewPos;
+    vec4 plane1_equation; // (a, b, c, d) where ax + by + cz + d = 0
+    vec4 plane2_equation;
+    vec4 plane3_equation;
+    vec4 plane4_equation;
+    bool plane1_enabled;
+    bool plane2_enabled;
+    bool plane3_enabled;
+    bool plane4_enabled;
+    bool planeSlicingEnabled;
+};
 
-// Output to geometry shader
-out vec3 Position_gs;
-out vec3 Normal_gs;
-out vec3 Color_gs;
+// Per-segment explosion offsets of the sliced mesh, one texel per segment
+uniform bool segmentExplosionEnabled;
+uniform samplerBuffer segmentOffsets;
+
+// Segment picked with the mouse, -1 for none
+uniform int highlightedSegment;
+
+// Set while drawing the mesh as region passes. The mesh is drawn once per
+// region, 2^k instances for k enabled planes; instance bits pick the side of
+// each enabled plane and the hardware clips everything else away.
+uniform bool regionPassEnabled;
+
+// Segment colors - same as in mesh_slicer.h
+const vec3 SEGMENT_COLORS[8] = vec3[8](
+    vec3(1.0, 0.0, 0.0),   // Red
+    vec3(0.0, 1.0, 0.0),   // Green
+    vec3(0.0, 0.0, 1.0),   // Blue
+    vec3(1.0, 1.0, 0.0),   // Yellow
+    vec3(1.0, 0.0, 1.0),   // Magenta
+    vec3(0.0, 1.0, 1.0),   // Cyan
+    vec3(1.0, 0.5, 0.0),   // Orange
+    vec3(0.5, 0.0, 1.0)    // Purple
+);
+
+out float gl_ClipDistance[4];
+
+// Output to fragment shader
+out vec3 FragPos;
+out vec3 Normal_vs;
+out vec3 WorldPos;
+out vec3 WorldNormal;
+out vec3 Color_vs;
+out float Depth;
+out vec4 PlaneDistance;
+flat out int Highlighted;
 
 void main() {
-    // Transform vertex to world space
-    gl_Position = vec4(Position, 1.0);
-    Position_gs = Position;
-    Normal_gs = Normal;
-    Color_gs = Color;
-}
\ No newline at end of file
+    vec3 offset = vec3(0.0);
+    if (segmentExplosionEnabled) {
+        offset = texelFetch(segmentOffsets, SegmentId).xyz;
+    }
+    vec4 position = vec4(Position + offset, 1.0);
+
+    gl_Position = gProjection * gView * gWorld * position;
+    FragPos = (gView * gWorld * position).xyz;
+    Normal_vs = normalize(mat3(gView * gWorld) * Normal);
+    WorldPos = (gWorld * position).xyz;
+    WorldNormal = mat3(gWorld) * Normal;
+    Color_vs = Color;
+    Highlighted = (segmentExplosionEnabled && SegmentId == highlightedSegment) ? 1 : 0;
+
+    float distance = length(FragPos);
+    float zNear = 1.0;
+    float zFar = 30.0;
+    Depth = clamp((distance - zNear) / (zFar - zNear), 0.0, 1.0);
+
+    vec4 planes[4] = vec4[4](plane1_equation, plane2_equation, plane3_equation, plane4_equation);
+    bool enabled[4] = bool[4](plane1_enabled, plane2_enabled, plane3_enabled, plane4_enabled);
+
+    PlaneDistance = vec4(1.0);
+    int regionCode = 0;
+    int instanceBit = 0;
+    for (int i = 0; i < 4; i++) {
+        gl_ClipDistance[i] = 1.0;
+        if (!regionPassEnabled || !enabled[i]) {
+            continue;
+        }
+
+        float d = dot(planes[i].xyz, position.xyz) + planes[i].w;
+        PlaneDistance[i] = d;
+
+        // Region code bit i set means the positive side of plane i, as in
+        // the CPU slicer.
+        bool positive = ((gl_InstanceID >> instanceBit) & 1) != 0;
+        instanceBit++;
+        if (positive) {
+            regionCode |= 1 << i;
+        }
+        gl_ClipDistance[i] = positive ? d : -d;
+    }
+
+    if (regionPassEnabled) {
+        Color_vs = mix(Color, SEGMENT_COLORS[regionCode % 8], 0.7);
+    }
+}
@@ -0,0 +1,338 @@
+// Headless benchmark for the mesh slicer. Loads every OFF file in the given
+// directories (meshes/ and meshes/Geometry by default), slices each one with
+// a generated plane set and writes one CSV row per mesh and plane count.
+// With -l it times layered contour extraction instead. With -P every slicer
+// policy combination (slice_engine.h) runs on the same planes, one row each.
+// -t sets the size of the task pool that loading, normals, slicing and
+// contours run on (default one thread per core).
+//
+//   ./slice_bench [-p 1-16] [-m random|axis] [-s seed] [-t threads] [-r repeat] [-P] [-o out.csv] [dirs...]
+//   ./slice_bench -l layers [-a x|y|z] [-t threads] [-r repeat] [-o out.csv] [dirs...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include "math_utils.h"
+#include "OFFReader.h"
+#include "normal.h"
+#include "plane.h"
+#include "mesh_slicer.h"
+#include "contour_slicer.h"
+
+MeshSlicerState g_slicerState;
+LogState g_log;
+TaskSystem g_tasks;
+bool g_meshInitialized = false;
+float planeSize = 1.0f;
+
+typedef std::chrono::high_resolution_clock BenchClock;
+
+double elapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+long peakRSSKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void listMeshes(const char* dir, std::vector<std::string>& files) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "Warning: Could not open directory %s\n", dir);
+        return;
+    }
+
+    std::vector<std::string> found;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".off") == 0) {
+            found.push_back(std::string(dir) + "/" + name);
+        }
+    }
+    closedir(d);
+
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+// Random planes pass through a random point inside the bounding box with a
+// random orientation. Axis planes cycle through x, y and z and split each axis
+// into equal slabs.
+std::vector<Plane> makePlanes(OffModel* model, int count, bool axisAligned, std::mt19937& rng) {
+    std::vector<Plane> planes;
+    Vector3f minP(model->minX, model->minY, model->minZ);
+    Vector3f maxP(model->maxX, model->maxY, model->maxZ);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+
+    for (int i = 0; i < count; i++) {
+        Plane p;
+        p.enabled = true;
+
+        if (axisAligned) {
+            int axis = i % 3;
+            int perAxis = (count - axis + 2) / 3;
+            float t = (float)(i / 3 + 1) / (perAxis + 1);
+
+            p.a = axis == 0 ? 1.0f : 0.0f;
+            p.b = axis == 1 ? 1.0f : 0.0f;
+            p.c = axis == 2 ? 1.0f : 0.0f;
+            float lo = axis == 0 ? minP.x : (axis == 1 ? minP.y : minP.z);
+            float hi = axis == 0 ? maxP.x : (axis == 1 ? maxP.y : maxP.z);
+            p.d = -(lo + t * (hi - lo));
+        } else {
+            Vector3f n(gauss(rng), gauss(rng), gauss(rng));
+            if (n.length() < 0.0001f) {
+                n = Vector3f(0.0f, 1.0f, 0.0f);
+            }
+            n.Normalize();
+
+            Vector3f point(minP.x + unit(rng) * (maxP.x - minP.x),
+                           minP.y + unit(rng) * (maxP.y - minP.y),
+                           minP.z + unit(rng) * (maxP.z - minP.z));
+
+            p.a = n.x;
+            p.b = n.y;
+            p.c = n.z;
+            p.d = -(n.x * point.x + n.y * point.y + n.z * point.z);
+        }
+
+        planes.push_back(p);
+    }
+
+    return planes;
+}
+
+bool parsePlaneRange(const char* arg, int& minPlanes, int& maxPlanes) {
+    if (sscanf(arg, "%d-%d", &minPlanes, &maxPlanes) != 2) {
+        if (sscanf(arg, "%d", &minPlanes) != 1) {
+            return false;
+        }
+        maxPlanes = minPlanes;
+    }
+    return minPlanes >= 1 && maxPlanes <= 16 && minPlanes <= maxPlanes;
+}
+
+void printUsage(const char* name) {
+    fprintf(stderr, "Usage: %s [-p 1-16] [-m random|axis] [-s seed] [-t threads] [-r repeat] [-P] [-o out.csv] [dirs...]\n", name);
+    fprintf(stderr, "       %s -l layers [-a x|y|z] [-t threads] [-r repeat] [-o out.csv] [dirs...]\n", name);
+}
+
+void benchContours(FILE* out, const std::string& file, OffModel* model, double loadMs,
+                   int layerCount, char axis, int repeat) {
+    Vector3f normal(axis == 'x' ? 1.0f : 0.0f, axis == 'y' ? 1.0f : 0.0f, axis == 'z' ? 1.0f : 0.0f);
+
+    std::vector<ContourLayer> layers;
+    double contourMs = 0.0;
+    for (int r = 0; r < repeat; r++) {
+        BenchClock::time_point start = BenchClock::now();
+        layers = extractContours(model, normal, layerCount);
+        double ms = elapsedMs(start);
+        contourMs = r == 0 ? ms : std::min(contourMs, ms);
+    }
+
+    size_t polylines = 0, openPolylines = 0, points = 0;
+    for (const ContourLayer& layer : layers) {
+        polylines += layer.polylines.size();
+        points += layer.points.size();
+        for (const ContourPolyline& polyline : layer.polylines) {
+            if (!polyline.closed) {
+                openPolylines++;
+            }
+        }
+    }
+    double trisPerSec = contourMs > 0.0 ? model->numberOfPolygons / (contourMs / 1000.0) : 0.0;
+
+    fprintf(out, "%s,%c,%d,%d,%.3f,%.3f,%zu,%zu,%zu,%.0f,%ld\n",
+            file.c_str(), axis, layerCount, model->numberOfPolygons, loadMs, contourMs,
+            polylines, openPolylines, points, trisPerSec, peakRSSKb());
+}
+
+template <typename Weld, typename Degenerates, typename Snap>
+void benchPolicy(FILE* out, const std::string& file, OffModel* model, const std::vector<Plane>& planes, int repeat) {
+    std::shared_ptr<const SegmentArena> arena;
+    std::vector<SliceRegion> regions;
+    double sliceMs = 0.0;
+    for (int r = 0; r < repeat; r++) {
+        BenchClock::time_point start = BenchClock::now();
+        slicePolygons<Weld, Degenerates, Snap>(model, planes, arena, regions);
+        double ms = elapsedMs(start);
+        sliceMs = r == 0 ? ms : std::min(sliceMs, ms);
+    }
+    double trisPerSec = sliceMs > 0.0 ? model->numberOfPolygons / (sliceMs / 1000.0) : 0.0;
+
+    fprintf(out, "%s,%zu,%d,%s,%s,%s,%.3f,%zu,%zu,%zu,%.0f\n",
+            file.c_str(), planes.size(), model->numberOfPolygons,
+            Weld::enabled ? "weld" : "none", Degenerates::enabled ? "skip" : "keep", Snap::enabled ? "snap" : "none",
+            sliceMs, regions.size(), arena->vertices.size(), arena->indices.size() / 3, trisPerSec);
+}
+
+void benchPolicies(FILE* out, const std::string& file, OffModel* model, const std::vector<Plane>& planes, int repeat) {
+    benchPolicy<NoWeld, KeepDegenerates, NoSnap>(out, file, model, planes, repeat);
+    benchPolicy<NoWeld, KeepDegenerates, SnapToVertices>(out, file, model, planes, repeat);
+    benchPolicy<NoWeld, SkipDegenerates, NoSnap>(out, file, model, planes, repeat);
+    benchPolicy<NoWeld, SkipDegenerates, SnapToVertices>(out, file, model, planes, repeat);
+    benchPolicy<WeldVertices, KeepDegenerates, NoSnap>(out, file, model, planes, repeat);
+    benchPolicy<WeldVertices, KeepDegenerates, SnapToVertices>(out, file, model, planes, repeat);
+    benchPolicy<WeldVertices, SkipDegenerates, NoSnap>(out, file, model, planes, repeat);
+    benchPolicy<WeldVertices, SkipDegenerates, SnapToVertices>(out, file, model, planes, repeat);
+}
+
+int main(int argc, char* argv[]) {
+    int minPlanes = 1, maxPlanes = 16;
+    bool axisAligned = false;
+    unsigned int seed = 1;
+    int repeat = 3;
+    const char* outPath = "slice_bench.csv";
+    int layerCount = 0;
+    char axis = 'z';
+    unsigned int threads = 0;
+    bool policies = false;
+    std::vector<const char*> dirs;
+    g_log.level = LOG_LEVEL_WARN;  // keep per-slice summaries out of the timings
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-p") == 0 && hasValue) {
+            if (!parsePlaneRange(argv[++i], minPlanes, maxPlanes)) {
+                fprintf(stderr, "Plane count must be in 1-16\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-m") == 0 && hasValue) {
+            axisAligned = strcmp(argv[++i], "axis") == 0;
+        } else if (strcmp(argv[i], "-s") == 0 && hasValue) {
+            seed = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && hasValue) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-l") == 0 && hasValue) {
+            layerCount = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-a") == 0 && hasValue) {
+            axis = argv[++i][0];
+        } else if (strcmp(argv[i], "-t") == 0 && hasValue) {
+            threads = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-P") == 0) {
+            policies = true;
+        } else if (strcmp(argv[i], "-o") == 0 && hasValue) {
+            outPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            dirs.push_back(argv[i]);
+        }
+    }
+
+    startTaskSystem(g_tasks, threads);
+
+    if (dirs.empty()) {
+        dirs.push_back("meshes");
+        dirs.push_back("meshes/Geometry");
+    }
+
+    std::vector<std::string> files;
+    for (const char* dir : dirs) {
+        listMeshes(dir, files);
+    }
+
+    FILE* out = fopen(outPath, "w");
+    if (!out) {
+        fprintf(stderr, "Error: Could not open %s for writing\n", outPath);
+        return 1;
+    }
+    if (layerCount > 0) {
+        fprintf(out, "mesh,axis,layers,triangles,load_ms,contour_ms,polylines,open_polylines,points,tris_per_sec,peak_rss_kb\n");
+    } else if (policies) {
+        fprintf(out, "mesh,planes,triangles,weld,degenerates,snap,slice_ms,segments,out_vertices,out_triangles,tris_per_sec\n");
+    } else {
+        fprintf(out, "mesh,mode,planes,triangles,load_ms,normal_ms,slice_ms,pack_ms,segments,out_triangles,tris_per_sec,peak_rss_kb\n");
+    }
+
+    std::vector<Vertex> packed;
+
+    for (const std::string& file : files) {
+        std::vector<char> path(file.begin(), file.end());
+        path.push_back('\0');
+
+        if (!startsWithOffHeader(path.data())) {
+            fprintf(stderr, "Skipping %s: not a plain OFF file\n", file.c_str());
+            continue;
+        }
+
+        BenchClock::time_point start = BenchClock::now();
+        OffModel* model = readOffFile(path.data());
+        double loadMs = elapsedMs(start);
+        if (!model) {
+            fprintf(stderr, "Skipping %s: could not be read\n", file.c_str());
+            continue;
+        }
+
+        if (layerCount > 0) {
+            benchContours(out, file, model, loadMs, layerCount, axis, repeat);
+            fflush(out);
+            fprintf(stderr, "%s: %d triangles done\n", file.c_str(), model->numberOfPolygons);
+            FreeOffModel(model);
+            continue;
+        }
+
+        start = BenchClock::now();
+        calculateVertexNormals(model);
+        double normalMs = elapsedMs(start);
+
+        g_slicerState = MeshSlicerState();
+        g_slicerState.model = model;
+        g_meshInitialized = true;
+
+        for (int planeCount = minPlanes; planeCount <= maxPlanes; planeCount++) {
+            std::mt19937 rng(seed + planeCount);
+            std::vector<Plane> planes = makePlanes(model, planeCount, axisAligned, rng);
+            if (policies) {
+                benchPolicies(out, file, model, planes, repeat);
+                continue;
+            }
+
+            // Best of N keeps the numbers stable enough to compare builds.
+            double sliceMs = 0.0, packMs = 0.0;
+            for (int r = 0; r < repeat; r++) {
+                start = BenchClock::now();
+                sliceWithPlanes(g_slicerState, planes);
+                double ms = elapsedMs(start);
+                sliceMs = r == 0 ? ms : std::min(sliceMs, ms);
+
+                start = BenchClock::now();
+                for (size_t s = 0; s < g_slicerState.segments.size(); s++) {
+                    packSegmentVertices(g_slicerState, g_slicerState.segments[s], s, packed);
+                }
+                ms = elapsedMs(start);
+                packMs = r == 0 ? ms : std::min(packMs, ms);
+            }
+
+            size_t outTriangles = g_slicerState.arena->indices.size() / 3;
+            double trisPerSec = sliceMs > 0.0 ? model->numberOfPolygons / (sliceMs / 1000.0) : 0.0;
+
+            fprintf(out, "%s,%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%zu,%zu,%.0f,%ld\n",
+                    file.c_str(), axisAligned ? "axis" : "random", planeCount,
+                    model->numberOfPolygons, loadMs, normalMs, sliceMs, packMs,
+                    g_slicerState.segments.size(), outTriangles, trisPerSec, peakRSSKb());
+        }
+        fflush(out);
+
+        fprintf(stderr, "%s: %d triangles done\n", file.c_str(), model->numberOfPolygons);
+        g_slicerState = MeshSlicerState();
+        FreeOffModel(model);
+    }
+
+    fclose(out);
+    fprintf(stderr, "Wrote %zu meshes to %s\n", files.size(), outPath);
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "math_utils.h"
 #include "OFFReader.h"
 #include "file_utils.h"
+#include "log.h"
 #include <vector>
 
 
@@ -21,15 +22,15 @@ typedef struct Plane{
     
     void normalize() {
         float magnitude = sqrtf(a*a + b*b + c*c);
-        printf("Pre-normalize: (%.2f, %.2f, %.2f, %.2f), magnitude = %.2f\n", a, b, c, d, magnitude);
+        LOG_DEBUG("Pre-normalize: (%.2f, %.2f, %.2f, %.2f), magnitude = %.2f\n", a, b, c, d, magnitude);
         if (magnitude > 0.0001f) {
             a /= magnitude;
             b /= magnitude;
             c /= magnitude;
             d /= magnitude;
-            printf("Post-normalize: (%.2f, %.2f, %.2f, %.2f)\n", a, b, c, d);
+            LOG_DEBUG("Post-normalize: (%.2f, %.2f, %.2f, %.2f)\n", a, b, c, d);
         } else {
-            printf("Magnitude too small (%.6f), not normalizing\n", magnitude);
+            LOG_DEBUG("Magnitude too small (%.6f), not normalizing\n", magnitude);
         }
     }
     
@@ -43,8 +44,8 @@ void updatePlaneBuffers(const std::vector<Plane>& planes, float size);
 
 
 void updateActivePlanes(const Plane& plane1, const Plane& plane2, const Plane& plane3, const Plane& plane4, std::vector<Plane>& active_planes) {
-    printf("\n======== UPDATING ACTIVE PLANES ========\n");
-    printf("Before update: active_planes size = %zu\n", active_planes.size());
+    LOG_DEBUG("\n======== UPDATING ACTIVE PLANES ========\n");
+    LOG_DEBUG("Before update: active_planes size = %zu\n", active_planes.size());
     active_planes.clear();
     
     if (plane1.enabled) {
@@ -57,7 +58,7 @@ void updateActivePlanes(const Plane& plane1, const Plane& plane2, const Plane& p
             p.d /= magnitude;
         }
         active_planes.push_back(p);
-        printf("Plane 1 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
+        LOG_DEBUG("Plane 1 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
     }
     
     if (plane2.enabled) {
@@ -70,7 +71,7 @@ void updateActivePlanes(const Plane& plane1, const Plane& plane2, const Plane& p
             p.d /= magnitude;
         }
         active_planes.push_back(p);
-        printf("Plane 2 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
+        LOG_DEBUG("Plane 2 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
     }
     
     if (plane3.enabled) {
@@ -83,7 +84,7 @@ void updateActivePlanes(const Plane& plane1, const Plane& plane2, const Plane& p
             p.d /= magnitude;
         }
         active_planes.push_back(p);
-        printf("Plane 3 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
+        LOG_DEBUG("Plane 3 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
     }
     
     if (plane4.enabled) {
@@ -96,11 +97,12 @@ void updateActivePlanes(const Plane& plane1, const Plane& plane2, const Plane& p
             p.d /= magnitude;
         }
         active_planes.push_back(p);
-        printf("Plane 4 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
+        LOG_DEBUG("Plane 4 added: (%.2f, %.2f, %.2f, %.2f)\n", p.a, p.b, p.c, p.d);
     }
     
-    printf("After update: active_planes size = %zu\n", active_planes.size());
-    printf("=========================================\n\n");
+    LOG_DEBUG("=========================================\n\n");
+    LOG_COUNT(LOG_PLANE_UPDATES, 1);
+    LOG_SUMMARY(LOG_STAGE_PLANES, "%zu active planes", active_planes.size());
     
 
 }
@@ -19,6 +19,7 @@
 #include "light.h"
 #include "plane.h"
 #include "mesh_slicer.h"
+#include "log_ui.h"
 
 #define GL_SILENCE_DEPRECATION
 
@@ -34,6 +35,7 @@ Plane plane4;
 std::vector<Plane> active_planes;
 
 MeshSlicerState g_slicerState;
+LogState g_log;
 bool g_meshInitialized = false;
 bool meshSliced = false;
 GLuint slicedVAO = 0, slicedVBO = 0, slicedIBO = 0;
@@ -963,7 +965,7 @@ int main(int argc, char *argv[])
         ImGui::PopID();
 
         if (plane1Changed || plane2Changed || plane3Changed || plane4Changed) {
-            printf("Changing plane data\n");
+            LOG_DEBUG("Changing plane data\n");
             updateActivePlanes(plane1, plane2, plane3, plane4, active_planes);
             updatePlaneBuffers(active_planes, planeSize);
         }
@@ -1035,7 +1037,7 @@ int main(int argc, char *argv[])
             uploadToGPU(slicedVAO, slicedVBO, slicedIBO, slicedVertexCount);
             meshSliced = true;
             
-            printf("Mesh sliced into %zu segments with different colors\n", getSegmentCount());
+            LOG_INFO("Mesh sliced into %zu segments with different colors\n", getSegmentCount());
         }
 
         if (ImGui::Button("Reset Mesh")) {
@@ -1044,6 +1046,9 @@ int main(int argc, char *argv[])
 
         ImGui::Text("Active planes: %zu", active_planes.size());
         ImGui::Text("Mesh segments: %zu", meshSliced ? getSegments().size() : 0);
+        if (ImGui::CollapsingHeader("Log")) {
+            drawLogPanel(g_log);
+        }
 
         ImGui::End();
 
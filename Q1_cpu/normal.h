@@ -15,6 +15,7 @@
 #include "math_utils.h"
 
 #include "OFFReader.h"
+#include "log.h"
 
 Vector3f* calculateFaceNormals(OffModel* model) {
     Vector3f* normals = new Vector3f[model->numberOfPolygons];
@@ -130,7 +131,7 @@ explodedVertices.reserve(model->numberOfPolygons * 3);
 for (int i = 0; i < model->numberOfPolygons; i++) {
 // All polygons should be triangles after triangulation
 if (model->polygons[i].noSides != 3) {
-printf("Warning: Found non-triangle polygon (%d sides) at index %d!\n", 
+LOG_WARN_EVERY(LOG_NON_TRIANGLES, 1, "Warning: Found non-triangle polygon (%d sides) at index %d",
 model->polygons[i].noSides, i);
 continue;
 }
@@ -172,8 +173,9 @@ explodedVertices.data(), GL_STATIC_DRAW);
 // Remember how many vertices we now have
 numVertices = explodedVertices.size();
 
-printf("Exploded mesh into %d triangles (%d vertices)\n", 
-model->numberOfPolygons, numVertices);
+LOG_COUNT(LOG_EXPLOSION_UPDATES, 1);
+LOG_SUMMARY(LOG_STAGE_EXPLOSION, "factor %.2f, %d triangles (%d vertices)",
+explosionFactor, model->numberOfPolygons, numVertices);
 }
 
 
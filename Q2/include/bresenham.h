@@ -0,0 +1,95 @@
+#ifndef BRESENHAM_H
+#define BRESENHAM_H
+
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+// A straight piece of a rasterized line: length pixels starting at (x, y)
+// and going towards +x, or towards +y when vertical is set. The four ints
+// are uploaded as they are, one instance per run.
+struct BresenhamRun {
+    int x, y;
+    int length;
+    int vertical;
+};
+
+// A line turned into the first octant: major steps go 0..dx from x0, minor
+// ones 0..dy from y0 in direction yStep. Steep lines have x and y swapped.
+struct BresenhamLine {
+    int x0, y0;
+    long long dx, dy;
+    int yStep;
+    bool steep;
+};
+
+BresenhamLine normalizeBresenhamLine(int x0, int y0, int x1, int y1) {
+    BresenhamLine line;
+    line.steep = abs(y1 - y0) > abs(x1 - x0);
+    if (line.steep) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    line.x0 = x0;
+    line.y0 = y0;
+    line.dx = x1 - x0;
+    line.dy = abs(y1 - y0);
+    line.yStep = (y0 < y1) ? 1 : -1;
+    return line;
+}
+
+// The usual Bresenham loop (d = 2dy - dx, step the minor axis when d > 0)
+// has taken floor((2dy*i + dx - 1) / 2dx) minor steps after i major ones.
+long long bresenhamMinorOffset(const BresenhamLine& line, long long i) {
+    return line.dx > 0 ? (2 * line.dy * i + line.dx - 1) / (2 * line.dx) : 0;
+}
+
+// First major step at minor offset k: ceil((2dx*k - dx + 1) / 2dy), or
+// dx + 1 past the last one.
+long long bresenhamRunStart(const BresenhamLine& line, long long k) {
+    if (k <= 0) {
+        return 0;
+    }
+    if (k > line.dy) {
+        return line.dx + 1;
+    }
+    return (2 * line.dx * k - line.dx + 1 + 2 * line.dy - 1) / (2 * line.dy);
+}
+
+// Decision variable of the loop just before major step i.
+long long bresenhamDecision(const BresenhamLine& line, long long i, long long k) {
+    return 2 * line.dy - line.dx + 2 * line.dy * i - 2 * line.dx * k;
+}
+
+// Appends the runs of the line from (x0, y0) to (x1, y1): the pixels the
+// Bresenham loop plots, one run per minor step, each computed directly
+// instead of pixel by pixel. A line has dy + 1 runs and dx + 1 pixels.
+void generateBresenhamRuns(int x0, int y0, int x1, int y1, std::vector<BresenhamRun>& runs) {
+    BresenhamLine line = normalizeBresenhamLine(x0, y0, x1, y1);
+    for (long long k = 0; k <= line.dy; k++) {
+        long long start = bresenhamRunStart(line, k);
+        int major = line.x0 + (int)start;
+        int minor = line.y0 + (int)k * line.yStep;
+        BresenhamRun run;
+        run.x = line.steep ? minor : major;
+        run.y = line.steep ? major : minor;
+        run.length = (int)(bresenhamRunStart(line, k + 1) - start);
+        run.vertical = line.steep ? 1 : 0;
+        runs.push_back(run);
+    }
+}
+
+// Number of pixels covered by the runs.
+size_t bresenhamPixelCount(const std::vector<BresenhamRun>& runs) {
+    size_t pixels = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        pixels += runs[i].length;
+    }
+    return pixels;
+}
+
+#endif
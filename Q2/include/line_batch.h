@@ -0,0 +1,218 @@
+#ifndef LINE_BATCH_H
+#define LINE_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "bresenham.h"
+#include "task_system.h"
+
+// Software rasterization of many lines into an RGBA framebuffer in memory.
+// The screen is cut into tiles of tileRows full rows. Every line is binned
+// into the tiles its rows touch, and each tile is cleared and drawn by one
+// task, so no two threads ever write the same pixel. Inside a tile a line is
+// drawn with the Bresenham loop resumed at the tile's first row; lines keep
+// their order within a tile, so overlaps come out as if drawn one by one.
+
+struct LineSegment {
+    int x0, y0, x1, y1;
+    uint32_t color;  // RGBA, red in the lowest byte
+};
+
+// Pixels [x0, x1) x [y0, y1); empty when x0 >= x1 or y0 >= y1.
+struct PixelRect {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+};
+
+bool pixelRectEmpty(const PixelRect& rect) {
+    return rect.x0 >= rect.x1 || rect.y0 >= rect.y1;
+}
+
+PixelRect pixelRectUnion(const PixelRect& a, const PixelRect& b) {
+    if (pixelRectEmpty(a)) {
+        return b;
+    }
+    if (pixelRectEmpty(b)) {
+        return a;
+    }
+    PixelRect rect;
+    rect.x0 = std::min(a.x0, b.x0);
+    rect.y0 = std::min(a.y0, b.y0);
+    rect.x1 = std::max(a.x1, b.x1);
+    rect.y1 = std::max(a.y1, b.y1);
+    return rect;
+}
+
+struct CpuFramebuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;  // bottom row first, as glTexImage2D expects
+    PixelRect dirty;               // changed since the last upload
+};
+
+struct LineBatch {
+    int tileRows = 32;
+    std::vector<unsigned int> tileStart;  // where each tile's lines start in tileLines
+    std::vector<unsigned int> tileLines;  // line indices grouped by tile
+
+    // Pixels the last batch may have touched. Everything else still holds
+    // background, so a new batch only changes the union of the two.
+    PixelRect drawn;
+    uint32_t background = 0;
+
+    // Last rasterizeLineBatch
+    double binMs = 0.0;
+    double rasterMs = 0.0;
+    size_t binnedLines = 0;  // lines counted once per tile they touch
+};
+
+void resizeFramebuffer(CpuFramebuffer& framebuffer, int width, int height) {
+    framebuffer.width = width;
+    framebuffer.height = height;
+    framebuffer.pixels.assign((size_t)width * height, 0);
+    framebuffer.dirty.x0 = 0;
+    framebuffer.dirty.y0 = 0;
+    framebuffer.dirty.x1 = width;
+    framebuffer.dirty.y1 = height;
+}
+
+// Plots the pixels of the segment that lie in rows [rowBegin, rowEnd) and
+// columns [0, width). Both axes are clipped in closed form before the loop
+// starts, so the loop itself only walks a pointer.
+void rasterizeLineRows(const LineSegment& segment, int rowBegin, int rowEnd, CpuFramebuffer& framebuffer) {
+    BresenhamLine line = normalizeBresenhamLine(segment.x0, segment.y0, segment.x1, segment.y1);
+    const int width = framebuffer.width;
+    long long majorLow = line.steep ? rowBegin : 0;
+    long long majorHigh = line.steep ? rowEnd - 1 : width - 1;
+    long long minorLow = line.steep ? 0 : rowBegin;
+    long long minorHigh = line.steep ? width - 1 : rowEnd - 1;
+
+    long long kFirst = line.yStep > 0 ? minorLow - line.y0 : line.y0 - minorHigh;
+    long long kLast = line.yStep > 0 ? minorHigh - line.y0 : line.y0 - minorLow;
+    kFirst = std::max(kFirst, 0LL);
+    kLast = std::min(kLast, line.dy);
+    if (kFirst > kLast) {
+        return;
+    }
+    long long first = std::max(std::max(0LL, majorLow - line.x0), bresenhamRunStart(line, kFirst));
+    long long last = std::min(std::min(line.dx, majorHigh - line.x0), bresenhamRunStart(line, kLast + 1) - 1);
+    if (first > last) {
+        return;
+    }
+
+    long long k = bresenhamMinorOffset(line, first);
+    long long d = bresenhamDecision(line, first, k);
+    int major = line.x0 + (int)first;
+    int minor = line.y0 + (int)k * line.yStep;
+    int x = line.steep ? minor : major;
+    int y = line.steep ? major : minor;
+    ptrdiff_t majorStride = line.steep ? width : 1;
+    ptrdiff_t minorStride = line.steep ? line.yStep : (ptrdiff_t)line.yStep * width;
+    uint32_t* pixel = framebuffer.pixels.data() + (size_t)y * width + x;
+    for (long long i = first; i <= last; i++) {
+        *pixel = segment.color;
+        pixel += majorStride;
+        if (d > 0) {
+            pixel += minorStride;
+            d += 2 * (line.dy - line.dx);
+        } else {
+            d += 2 * line.dy;
+        }
+    }
+}
+
+// Sorts the segments into the tiles their rows touch (count, prefix sum,
+// fill). Segments entirely off screen are dropped. Also gathers the bounds
+// of what they cover into batch.drawn.
+void binLineSegments(LineBatch& batch, const std::vector<LineSegment>& segments, const CpuFramebuffer& framebuffer) {
+    int tileCount = (framebuffer.height + batch.tileRows - 1) / batch.tileRows;
+    batch.tileStart.assign(tileCount + 1, 0);
+    batch.drawn = PixelRect();
+    if (tileCount == 0) {
+        batch.tileLines.clear();
+        return;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < segments.size(); i++) {
+            const LineSegment& segment = segments[i];
+            if (std::max(segment.x0, segment.x1) < 0 || std::min(segment.x0, segment.x1) >= framebuffer.width) {
+                continue;
+            }
+            int top = std::min(std::max(segment.y0, segment.y1), framebuffer.height - 1);
+            int bottom = std::max(std::min(segment.y0, segment.y1), 0);
+            if (bottom > top) {
+                continue;
+            }
+            if (pass == 0) {
+                PixelRect bounds;
+                bounds.x0 = std::max(std::min(segment.x0, segment.x1), 0);
+                bounds.x1 = std::min(std::max(segment.x0, segment.x1), framebuffer.width - 1) + 1;
+                bounds.y0 = bottom;
+                bounds.y1 = top + 1;
+                batch.drawn = pixelRectUnion(batch.drawn, bounds);
+            }
+            for (int tile = bottom / batch.tileRows; tile <= top / batch.tileRows; tile++) {
+                if (pass == 0) {
+                    batch.tileStart[tile + 1]++;
+                } else {
+                    batch.tileLines[batch.tileStart[tile]++] = (unsigned int)i;
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (int tile = 0; tile < tileCount; tile++) {
+                batch.tileStart[tile + 1] += batch.tileStart[tile];
+            }
+            batch.tileLines.resize(batch.tileStart[tileCount]);
+        } else {
+            // the fill advanced every start to the next tile's
+            for (int tile = tileCount; tile > 0; tile--) {
+                batch.tileStart[tile] = batch.tileStart[tile - 1];
+            }
+            batch.tileStart[0] = 0;
+        }
+    }
+    batch.binnedLines = batch.tileLines.size();
+}
+
+// Clears the framebuffer to background and draws every segment into it.
+// Marks dirty only what this batch or the previous one drew, unless the
+// background changed.
+void rasterizeLineBatch(LineBatch& batch, const std::vector<LineSegment>& segments, CpuFramebuffer& framebuffer,
+                        uint32_t background) {
+    auto start = std::chrono::high_resolution_clock::now();
+    PixelRect previous = batch.drawn;
+    binLineSegments(batch, segments, framebuffer);
+    if (background != batch.background) {
+        previous.x0 = 0;
+        previous.y0 = 0;
+        previous.x1 = framebuffer.width;
+        previous.y1 = framebuffer.height;
+        batch.background = background;
+    }
+    framebuffer.dirty = pixelRectUnion(framebuffer.dirty, pixelRectUnion(previous, batch.drawn));
+    auto binned = std::chrono::high_resolution_clock::now();
+
+    int tileCount = (int)batch.tileStart.size() - 1;
+    parallelFor(g_tasks, 0, tileCount, 1, [&](size_t firstTile, size_t lastTile) {
+        for (size_t tile = firstTile; tile < lastTile; tile++) {
+            int rowBegin = (int)tile * batch.tileRows;
+            int rowEnd = std::min(rowBegin + batch.tileRows, framebuffer.height);
+            std::fill(framebuffer.pixels.begin() + (size_t)rowBegin * framebuffer.width,
+                      framebuffer.pixels.begin() + (size_t)rowEnd * framebuffer.width, background);
+            for (unsigned int j = batch.tileStart[tile]; j < batch.tileStart[tile + 1]; j++) {
+                rasterizeLineRows(segments[batch.tileLines[j]], rowBegin, rowEnd, framebuffer);
+            }
+        }
+    });
+
+    auto end = std::chrono::high_resolution_clock::now();
+    batch.binMs = std::chrono::duration<double, std::milli>(binned - start).count();
+    batch.rasterMs = std::chrono::duration<double, std::milli>(end - binned).count();
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+#include <GL/glew.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "line_batch.h"
+#include "task_system.h"
+
+// Streams a CpuFramebuffer into a texture through two pixel buffer objects
+// used in turn. Only the framebuffer's dirty rectangle is copied: its rows
+// are packed into the PBO, and glTexSubImage2D then reads them from the PBO
+// on the GPU's schedule. While the driver may still be reading one PBO, the
+// next frame writes the other, so mapping it does not wait for that copy.
+
+struct TextureStream {
+    GLuint texture = 0;
+    GLuint pbos[2] = {0, 0};
+    GLuint queries[2] = {0, 0};  // GPU time of the upload from each PBO
+    bool queryPending[2] = {false, false};
+    size_t pboBytes[2] = {0, 0};
+    int width = 0;
+    int height = 0;
+    int next = 0;  // PBO the next upload writes
+
+    // Last upload
+    PixelRect rect;
+    size_t bytes = 0;
+    double cpuMs = 0.0;  // map, copy and glTexSubImage2D call
+    double gpuMs = 0.0;  // transfer into the texture, read a frame later
+};
+
+void createTextureStream(TextureStream& stream) {
+    glGenTextures(1, &stream.texture);
+    glBindTexture(GL_TEXTURE_2D, stream.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenBuffers(2, stream.pbos);
+    glGenQueries(2, stream.queries);
+}
+
+// Reads the time of the last upload from PBO i, if the GPU has finished it.
+void collectUploadTime(TextureStream& stream, int i) {
+    if (!stream.queryPending[i]) {
+        return;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(stream.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(stream.queries[i], GL_QUERY_RESULT, &elapsedNs);
+        stream.gpuMs = elapsedNs / 1.0e6;
+        stream.queryPending[i] = false;
+    }
+}
+
+// Uploads the dirty part of the framebuffer and clears its dirty rectangle.
+// A new size reallocates the texture and uploads everything.
+void streamFramebuffer(TextureStream& stream, CpuFramebuffer& framebuffer) {
+    auto start = std::chrono::high_resolution_clock::now();
+    glBindTexture(GL_TEXTURE_2D, stream.texture);
+    if (stream.width != framebuffer.width || stream.height != framebuffer.height) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, framebuffer.width, framebuffer.height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        stream.width = framebuffer.width;
+        stream.height = framebuffer.height;
+        framebuffer.dirty.x0 = 0;
+        framebuffer.dirty.y0 = 0;
+        framebuffer.dirty.x1 = framebuffer.width;
+        framebuffer.dirty.y1 = framebuffer.height;
+    }
+
+    PixelRect rect = framebuffer.dirty;
+    rect.x0 = std::max(rect.x0, 0);
+    rect.y0 = std::max(rect.y0, 0);
+    rect.x1 = std::min(rect.x1, framebuffer.width);
+    rect.y1 = std::min(rect.y1, framebuffer.height);
+    framebuffer.dirty = PixelRect();
+    stream.rect = rect;
+    stream.bytes = 0;
+    if (pixelRectEmpty(rect)) {
+        stream.cpuMs = 0.0;
+        return;
+    }
+
+    collectUploadTime(stream, 0);
+    collectUploadTime(stream, 1);
+    int i = stream.next;
+    stream.next = 1 - i;
+
+    size_t rowBytes = (size_t)(rect.x1 - rect.x0) * sizeof(uint32_t);
+    size_t bytes = rowBytes * (rect.y1 - rect.y0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream.pbos[i]);
+    if (stream.pboBytes[i] < bytes) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        stream.pboBytes[i] = bytes;
+    }
+    // Invalidating lets the driver hand out fresh memory instead of waiting
+    // for a transfer that still reads the old contents.
+    uint8_t* mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        const uint32_t* pixels = framebuffer.pixels.data();
+        int width = framebuffer.width;
+        parallelFor(g_tasks, rect.y0, rect.y1, taskGrain(g_tasks, rect.y1 - rect.y0, 16), [&](size_t first, size_t last) {
+            for (size_t y = first; y < last; y++) {
+                memcpy(mapped + (y - rect.y0) * rowBytes, pixels + y * width + rect.x0, rowBytes);
+            }
+        });
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        glBeginQuery(GL_TIME_ELAPSED, stream.queries[i]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x0, rect.y0, rect.x1 - rect.x0, rect.y1 - rect.y0,
+                        GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glEndQuery(GL_TIME_ELAPSED);
+        stream.queryPending[i] = true;
+        stream.bytes = bytes;
+    } else {
+        fprintf(stderr, "Could not map the pixel buffer; skipped the upload\n");
+        framebuffer.dirty = rect;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    stream.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+#endif
@@ -14,6 +14,9 @@
 #include "backends/imgui_impl_opengl3.h"
 #include "file_utils.h"
 #include "math_utils.h"
+#include "bresenham.h"
+#include "line_batch.h"
+#include "texture_stream.h"
 #define GL_SILENCE_DEPRECATION
 
 /********************************************************************/
@@ -29,9 +32,22 @@ GLuint VBO, VAO, IBO;
 GLuint gWorldLocation;
 float linePoints[4] = {-0.5f, -0.5f, 0.5f, 0.5f}; // x1, y1, x2, y2
 bool drawLine = false;
-std::vector<std::pair<int, int>> bressenhamPoints;
-GLuint lineVAO, lineVBO;
+std::vector<BresenhamRun> bressenhamRuns;
+GLuint lineVAO, lineVBO, lineCornerVBO;
 GLuint ShaderProgram;
+GLuint gColorLocation;
+
+// Line batch rasterized on the CPU and shown as one textured quad
+TaskSystem g_tasks;
+bool drawBatch = false;
+bool rasterizeEveryFrame = true;
+bool batchDirty = true;
+std::vector<LineSegment> batchSegments;
+LineBatch lineBatch;
+CpuFramebuffer batchFramebuffer;
+TextureStream batchStream;
+GLuint batchVAO;
+GLuint TextureProgram;
 
 void toggleFullScreen(GLFWwindow* window) {
     if (isFullScreen) {
@@ -47,89 +63,60 @@ void toggleFullScreen(GLFWwindow* window) {
 }
 
 void generateBressenhamLine(int x0, int y0, int x1, int y1){
-    bressenhamPoints.clear();
+    bressenhamRuns.clear();
  
 	printf("Generating line from (%d,%d) to (%d,%d)\n", x0, y0, x1, y1);
-    
-    bool height_gradient = abs(y1 - y0) > abs(x1 - x0);
-    if (height_gradient) {
-        std::swap(x0, y0);
-        std::swap(x1, y1);
-    }
-    
-	// drawing from left to right
-    if (x0 > x1) {
-        std::swap(x0, x1);
-        std::swap(y0, y1);
-    }
-    
-    int dx = x1 - x0;
-    int dy = abs(y1 - y0);
-    int y_step = (y0 < y1) ? 1 : -1;
-    
-    int d = 2*dy - dx;
-    int y = y0;
-    
-    // Generating all points for the line
-    for (int x = x0; x <= x1; x++) {
-        if (height_gradient) {
-            bressenhamPoints.push_back(std::make_pair(y, x)); // If steep, we push the reversed coordinates
-        } else {
-            bressenhamPoints.push_back(std::make_pair(x, y)); // Normal case
-        }
-        
-        // Updating decision parameter and y-coordinate for next step of the algorithm
-        if (d > 0) {
-            y += y_step;
-            d += 2 * (dy - dx);
-        } else {
-            d += 2 * dy;
-        }
-    }
-    
-	printf("Generated %d points\n", bressenhamPoints.size());
+    generateBresenhamRuns(x0, y0, x1, y1, bressenhamRuns);
+	printf("Generated %zu runs covering %zu pixels\n", bressenhamRuns.size(), bresenhamPixelCount(bressenhamRuns));
 }
 
+// Every run is drawn as one instance of a unit quad that the vertex shader
+// stretches over the run's pixels, so a line costs 16 bytes per run rather
+// than 24 per pixel.
 void createLineBuffer(){
-    if (bressenhamPoints.empty()) return;
+    if (bressenhamRuns.empty()) return;
     
-    std::vector<float> lineVertices;
-    for (int i = 0; i < bressenhamPoints.size(); i++) {
-        int px = bressenhamPoints[i].first;
-        // int py = bressenhamPoints[i].second;
+    if (lineVAO == 0) {
+        float corners[] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
         
-        float x = (2.0f * px / theWindowWidth) - 1.0f;
-        float y = (2.0f * py / theWindowHeight) - 1.0f;
+        glGenVertexArrays(1, &lineVAO);
+        glGenBuffers(1, &lineCornerVBO);
+        glGenBuffers(1, &lineVBO);
         
-        lineVertices.push_back(x);     // x position
-        lineVertices.push_back(y);     // y position
-        lineVertices.push_back(0.0f);  // z position
-        lineVertices.push_back(1.0f);  // r color
-        lineVertices.push_back(1.0f);  // g color
-        lineVertices.push_back(0.0f);  // b color
-    }
-    
-    if (lineVAO != 0) {
-        glDeleteVertexArrays(1, &lineVAO);
-        glDeleteBuffers(1, &lineVBO);
+        glBindVertexArray(lineVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, lineCornerVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+        
+        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(1, 4, GL_INT, sizeof(BresenhamRun), 0);
+        glVertexAttribDivisor(1, 1);
     }
     
-    glGenVertexArrays(1, &lineVAO);
-    glGenBuffers(1, &lineVBO);
-    
     glBindVertexArray(lineVAO);
     glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-    
-    glBufferData(GL_ARRAY_BUFFER, lineVertices.size() * sizeof(float), lineVertices.data(), GL_STATIC_DRAW);
-    
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    
+    glBufferData(GL_ARRAY_BUFFER, bressenhamRuns.size() * sizeof(BresenhamRun), bressenhamRuns.data(), GL_STATIC_DRAW);
     glBindVertexArray(0);
     
-	printf("Created line buffer with %d points\n", bressenhamPoints.size());
+	printf("Created line buffer with %zu runs (%zu bytes)\n", bressenhamRuns.size(), bressenhamRuns.size() * sizeof(BresenhamRun));
+}
+
+// Random segments of at most maxLength pixels per axis inside a width x
+// height framebuffer.
+void generateBatchSegments(int count, int maxLength, int width, int height, unsigned int seed) {
+    srand(seed);
+    batchSegments.resize(count);
+    for (int i = 0; i < count; i++) {
+        LineSegment& segment = batchSegments[i];
+        segment.x0 = rand() % width;
+        segment.y0 = rand() % height;
+        segment.x1 = std::max(0, std::min(width - 1, segment.x0 + rand() % (2 * maxLength + 1) - maxLength));
+        segment.y1 = std::max(0, std::min(height - 1, segment.y0 + rand() % (2 * maxLength + 1) - maxLength));
+        segment.color = 0xff000000u | (rand() & 0xffffff) | 0x404040u;
+    }
+    batchDirty = true;
 }
 
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
@@ -142,6 +129,8 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 const int ANIMATION_DELAY = 400; /* milliseconds between rendering */
 const char *pVSFileName = "shaders/shader.vs";
 const char *pFSFileName = "shaders/shader.fs";
+const char *pTextureVSFileName = "shaders/texture.vs";
+const char *pTextureFSFileName = "shaders/texture.fs";
 
 /********************************************************************
   Utility functions
@@ -235,11 +224,11 @@ static void AddShader(GLuint ShaderProgram, const char *pShaderText, GLenum Shad
 
 using namespace std;
 
-static void CompileShaders()
+static GLuint LinkProgram(const char *pVSFile, const char *pFSFile)
 {
-	ShaderProgram = glCreateProgram();
+	GLuint Program = glCreateProgram();
 
-	if (ShaderProgram == 0)
+	if (Program == 0)
 	{
 		fprintf(stderr, "Error creating shader program\n");
 		exit(1);
@@ -247,30 +236,41 @@ static void CompileShaders()
 
 	string vs, fs;
 
-	if (!ReadFile(pVSFileName, vs))
+	if (!ReadFile(pVSFile, vs))
 	{
 		exit(1);
 	}
 
-	if (!ReadFile(pFSFileName, fs))
+	if (!ReadFile(pFSFile, fs))
 	{
 		exit(1);
 	}
 
-	AddShader(ShaderProgram, vs.c_str(), GL_VERTEX_SHADER);
-	AddShader(ShaderProgram, fs.c_str(), GL_FRAGMENT_SHADER);
+	AddShader(Program, vs.c_str(), GL_VERTEX_SHADER);
+	AddShader(Program, fs.c_str(), GL_FRAGMENT_SHADER);
 
 	GLint Success = 0;
 	GLchar ErrorLog[1024] = {0};
 
-	glLinkProgram(ShaderProgram);
-	glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &Success);
+	glLinkProgram(Program);
+	glGetProgramiv(Program, GL_LINK_STATUS, &Success);
 	if (Success == 0)
 	{
-		glGetProgramInfoLog(ShaderProgram, sizeof(ErrorLog), NULL, ErrorLog);
+		glGetProgramInfoLog(Program, sizeof(ErrorLog), NULL, ErrorLog);
 		fprintf(stderr, "Error linking shader program: '%s'\n", ErrorLog);
 		exit(1);
 	}
+	return Program;
+}
+
+static void CompileShaders()
+{
+	ShaderProgram = LinkProgram(pVSFileName, pFSFileName);
+	TextureProgram = LinkProgram(pTextureVSFileName, pTextureFSFileName);
+
+	GLint Success = 0;
+	GLchar ErrorLog[1024] = {0};
+
 	glBindVertexArray(VAO);
 	glValidateProgram(ShaderProgram);
 	glGetProgramiv(ShaderProgram, GL_VALIDATE_STATUS, &Success);
@@ -283,6 +283,11 @@ static void CompileShaders()
 
 	glUseProgram(ShaderProgram);
 	gWorldLocation = glGetUniformLocation(ShaderProgram, "gWorld");
+	gColorLocation = glGetUniformLocation(ShaderProgram, "gColor");
+
+	glUseProgram(TextureProgram);
+	glUniform1i(glGetUniformLocation(TextureProgram, "gFramebuffer"), 0);
+	glUseProgram(ShaderProgram);
 	// glBindVertexArray(0);
 }
 
@@ -298,6 +303,11 @@ void onInit(int argc, char *argv[])
 	CompileShaders();
 	lineVAO = 0;
     lineVBO = 0;
+    lineCornerVBO = 0;
+
+	// The quad's corners come from gl_VertexID; the VAO only has to exist.
+	glGenVertexArrays(1, &batchVAO);
+	createTextureStream(batchStream);
 
 	/* set to draw in window based on depth  */
 	glEnable(GL_DEPTH_TEST);
@@ -307,23 +317,44 @@ static void onDisplay()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    if (drawLine && lineVAO != 0 && !bressenhamPoints.empty()) {
-        glPointSize(1.0f);
+    if (drawBatch && batchFramebuffer.width > 0) {
+        if (rasterizeEveryFrame || batchDirty) {
+            rasterizeLineBatch(lineBatch, batchSegments, batchFramebuffer, 0xff1a1a1au);
+            batchDirty = false;
+        }
+        streamFramebuffer(batchStream, batchFramebuffer);
         
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(TextureProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, batchStream.texture);
+        glBindVertexArray(batchVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+        glEnable(GL_DEPTH_TEST);
+    }
+    
+    if (drawLine && lineVAO != 0 && !bressenhamRuns.empty()) {
         glUseProgram(ShaderProgram);
         
+        // Pixel coordinates to clip space
         Matrix4f World;
         for (int i = 0; i < 4; i++) {
             for (int j = 0; j < 4; j++) {
                 World.m[i][j] = (i == j) ? 1.0f : 0.0f;
             }
         }
+        World.m[0][0] = 2.0f / theWindowWidth;
+        World.m[1][1] = 2.0f / theWindowHeight;
+        World.m[0][3] = -1.0f;
+        World.m[1][3] = -1.0f;
         
         glUniformMatrix4fv(gWorldLocation, 1, GL_TRUE, &World.m[0][0]);
+        glUniform3f(gColorLocation, 1.0f, 1.0f, 0.0f);
         
         glBindVertexArray(lineVAO);
         
-        glDrawArrays(GL_POINTS, 0, bressenhamPoints.size());
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, bressenhamRuns.size());
         glBindVertexArray(0);
     }
 
@@ -431,11 +462,12 @@ void RenderImGui()
         drawLine = false;
     }
     
-    if (drawLine && !bressenhamPoints.empty()) {
+    if (drawLine && !bressenhamRuns.empty()) {
         ImGui::Separator();
         ImGui::Text("Line Information:");
         ImGui::Text("Endpoints: (%d, %d) to (%d, %d)", x0, y0, x1, y1);
-        ImGui::Text("Points plotted: %zu", bressenhamPoints.size());
+        ImGui::Text("Pixels plotted: %zu", bresenhamPixelCount(bressenhamRuns));
+        ImGui::Text("Runs: %zu (%zu bytes)", bressenhamRuns.size(), bressenhamRuns.size() * sizeof(BresenhamRun));
         
         float dx = x1 - x0;
         float dy = y1 - y0;
@@ -463,20 +495,58 @@ void RenderImGui()
         if (q3) ImGui::Text("Q3 "); ImGui::SameLine();
         if (q4) ImGui::Text("Q4");
         
-        if (ImGui::TreeNode("Sample Points")) {
-            int numToShow = std::min(10, (int)bressenhamPoints.size());
-            for (int i = 0; i < numToShow; i++) {
-                ImGui::Text("Point %d: (%d, %d)", i, bressenhamPoints[i].first, bressenhamPoints[i].second);
+        if (ImGui::TreeNode("Sample Runs")) {
+            size_t numToShow = std::min((size_t)10, bressenhamRuns.size());
+            for (size_t i = 0; i < numToShow; i++) {
+                const BresenhamRun& run = bressenhamRuns[i];
+                ImGui::Text("Run %zu: (%d, %d), %d pixels %s", i, run.x, run.y, run.length, run.vertical ? "up" : "right");
             }
             
-            if (bressenhamPoints.size() > numToShow) {
-                ImGui::Text("... and %zu more points", bressenhamPoints.size() - numToShow);
+            if (bressenhamRuns.size() > numToShow) {
+                ImGui::Text("... and %zu more runs", bressenhamRuns.size() - numToShow);
             }
             
             ImGui::TreePop();
         }
     }
     
+    if (ImGui::CollapsingHeader("Line Batch")) {
+        static int lineCount = 100000;
+        static int maxLength = 100;
+        static int sizeIndex = 2;
+        static unsigned int seed = 1;
+        const char* sizeNames[] = {"Window", "1280 x 720", "1920 x 1080"};
+        const int sizes[][2] = {{theWindowWidth, theWindowHeight}, {1280, 720}, {1920, 1080}};
+        
+        ImGui::Checkbox("Draw batch", &drawBatch);
+        bool regenerate = ImGui::SliderInt("Lines", &lineCount, 1000, 1000000, "%d", ImGuiSliderFlags_Logarithmic);
+        regenerate |= ImGui::SliderInt("Max length", &maxLength, 1, 2000, "%d", ImGuiSliderFlags_Logarithmic);
+        regenerate |= ImGui::Combo("Framebuffer", &sizeIndex, sizeNames, 3);
+        if (ImGui::Button("New lines")) {
+            seed++;
+            regenerate = true;
+        }
+        if (ImGui::SliderInt("Tile rows", &lineBatch.tileRows, 4, 256)) {
+            batchDirty = true;
+        }
+        ImGui::Checkbox("Rasterize every frame", &rasterizeEveryFrame);
+        
+        if (regenerate || batchFramebuffer.width == 0) {
+            resizeFramebuffer(batchFramebuffer, sizes[sizeIndex][0], sizes[sizeIndex][1]);
+            generateBatchSegments(lineCount, maxLength, batchFramebuffer.width, batchFramebuffer.height, seed);
+        }
+        
+        double frameMs = lineBatch.binMs + lineBatch.rasterMs;
+        ImGui::Text("%d x %d, %u threads", batchFramebuffer.width, batchFramebuffer.height, taskThreadCount(g_tasks));
+        ImGui::Text("Bin: %.2f ms (%zu tile entries)", lineBatch.binMs, lineBatch.binnedLines);
+        ImGui::Text("Rasterize: %.2f ms", lineBatch.rasterMs);
+        const PixelRect& rect = batchStream.rect;
+        ImGui::Text("Upload: %d x %d at (%d, %d), %.1f KB", rect.x1 - rect.x0, rect.y1 - rect.y0, rect.x0, rect.y0,
+                    batchStream.bytes / 1024.0);
+        ImGui::Text("Upload time: %.2f ms CPU, %.2f ms GPU", batchStream.cpuMs, batchStream.gpuMs);
+        ImGui::Text("%.2f M lines/s", frameMs > 0.0 ? batchSegments.size() / frameMs / 1000.0 : 0.0);
+    }
+    
     ImGui::End();
 
     ImGui::Render();
@@ -488,7 +558,7 @@ int main(int argc, char *argv[])
     glfwInit();
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
@@ -507,6 +577,7 @@ int main(int argc, char *argv[])
     glewInit();
     printf("GL version: %s\n", glGetString(GL_VERSION));
     onInit(argc, argv);
+    startTaskSystem(g_tasks);
 
     InitImGui(window);
 
@@ -523,6 +594,7 @@ int main(int argc, char *argv[])
         glfwPollEvents();
     }
 
+    stopTaskSystem(g_tasks);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
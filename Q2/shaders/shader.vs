@@ -1,14 +1,17 @@
 #version 330
-layout(location = 0)in vec3 Position;
-layout(location = 1)in vec3 Color;
+layout(location = 0)in vec2 Corner;
+layout(location = 1)in ivec4 Run;
 
 out vec3 outColor;
 
 uniform mat4 gWorld;
+uniform vec3 gColor;
 
+// One instance per run: x, y, length and whether it goes up or right.
 void main()
 {
-    gl_Position = gWorld * vec4(Position, 1.0);
-    outColor = Color;
+    vec2 extent = (Run.w != 0) ? vec2(1.0, float(Run.z)) : vec2(float(Run.z), 1.0);
+    vec2 pixel = vec2(Run.xy) + Corner * extent;
+    gl_Position = gWorld * vec4(pixel, 0.0, 1.0);
+    outColor = gColor;
 }
-
@@ -0,0 +1,10 @@
+#version 330
+in vec2 TexCoord;
+layout(location = 0) out vec4 diffuseColor;
+
+uniform sampler2D gFramebuffer;
+
+void main()
+{
+    diffuseColor = texture(gFramebuffer, TexCoord);
+}
@@ -0,0 +1,11 @@
+#version 330
+
+out vec2 TexCoord;
+
+// Full-screen quad drawn as a 4-vertex triangle strip without vertex data.
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+    TexCoord = corner;
+}